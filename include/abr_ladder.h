@@ -0,0 +1,32 @@
+//
+// Created by Jianing on 2026/01/20.
+//
+
+#ifndef FFMPEGPROJECT_ABR_LADDER_H
+#define FFMPEGPROJECT_ABR_LADDER_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+// 码率阶梯中的一档输出
+struct LadderRendition {
+    std::string output_file;
+    int height = 0;              // 目标高度，宽度按源宽高比计算
+    int64_t bit_rate = 1000000;  // 覆盖编码配置中的码率/GOP
+    int gop_size = 10;
+};
+
+// 码率阶梯任务参数
+struct LadderOptions {
+    std::vector<LadderRendition> renditions;
+    std::string encoder_profile = "mpeg4";  // 各档共用的编码配置（encoder_profile.h中的内置配置名）
+    int scale_threads = 2;       // 每档缩放线程的切片并行数
+    int branch_capacity = 8;     // 广播环容量（最慢一档落后一整圈时阻塞解码）
+    bool allow_upscale = false;  // false时跳过高于源分辨率的档位
+};
+
+// 码率阶梯任务：只解码一次，并行输出多档分辨率/码率；打开输入或没有可用档位时返回false
+bool run_abr_ladder(const char* input_file, const LadderOptions& opts);
+
+#endif //FFMPEGPROJECT_ABR_LADDER_H
@@ -0,0 +1,24 @@
+//
+// Created by Jianing on 2026/01/23.
+//
+
+#ifndef FFMPEGPROJECT_BOX_DOWNSCALE_H
+#define FFMPEGPROJECT_BOX_DOWNSCALE_H
+
+extern "C" {
+#include <libavutil/frame.h>
+}
+
+class SliceWorkers;
+
+// 源→目标恰为2:1或4:1（宽高同倍、目标宽高为偶数）时返回倍数，否则返回0
+int box_downscale_factor(int src_w, int src_h, int dst_w, int dst_h);
+
+// YUV420P/YUVJ420P按factor做盒式平均缩小（代理文件生成用）。dst需已按源的1/factor分配好
+// YUV420P缓冲；workers非空时按输出行带并行
+void box_downscale_yuv420p(const AVFrame* src, AVFrame* dst, int factor, SliceWorkers* workers = nullptr);
+
+// 基准：对width x height的YUV420P帧分别做2:1/4:1缩小，输出各内核及swscale(SWS_AREA)的GB/s
+void box_downscale_benchmark(int width, int height, int iterations);
+
+#endif //FFMPEGPROJECT_BOX_DOWNSCALE_H
@@ -0,0 +1,80 @@
+//
+// Created by Jianing on 2026/01/21.
+//
+
+#ifndef FFMPEGPROJECT_BROADCAST_RING_H
+#define FFMPEGPROJECT_BROADCAST_RING_H
+
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include <deque>
+#include <string>
+#include <stdint.h>
+
+extern "C" {
+#include <libavutil/frame.h>
+}
+
+// 单生产者/多消费者广播帧环：每个消费者有独立读游标，同一帧对所有消费者可见；
+// 槽位在所有登记的消费者都读过（释放）后才回收，帧数据只引用不拷贝。
+// 普通消费者落后一整圈时生产者阻塞；有损消费者（lossy）则被直接跳到最旧的可用帧，不拖慢生产者
+class BroadcastFrameRing {
+public:
+    // 单个消费者的统计
+    struct ConsumerStats {
+        std::string name;
+        bool lossy = false;
+        uint64_t consumed = 0;   // 已读取帧数
+        uint64_t skipped = 0;    // 有损模式下被跳过的帧数
+        uint64_t lag = 0;        // 当前落后生产者的帧数
+        uint64_t max_lag = 0;    // 历史最大落后帧数
+    };
+
+    explicit BroadcastFrameRing(uint32_t capacity = 30);
+    ~BroadcastFrameRing();
+
+    BroadcastFrameRing(const BroadcastFrameRing&) = delete;
+    BroadcastFrameRing& operator=(const BroadcastFrameRing&) = delete;
+
+    // 登记消费者，从下一帧开始接收（应在生产者开始push前登记）；返回消费者id
+    int add_consumer(const std::string& name, bool lossy = false);
+    // 消费者提前退出：释放它尚未读取的槽位，之后不再阻塞生产者
+    void remove_consumer(int id);
+
+    // 生产者推送（av_frame_ref）；flush后返回false
+    bool push(const AVFrame* frame);
+    // 消费者id读取下一帧到dst（av_frame_ref）；流结束且已读完返回false
+    bool pop(int id, AVFrame* dst);
+    // 流结束信号：消费者读完剩余帧后退出
+    void flush();
+
+    std::vector<ConsumerStats> stats();
+    void print_stats();
+
+private:
+    struct Slot {
+        AVFrame* frame = nullptr;
+        int pending = 0;          // 还需要读取该槽位的消费者数
+    };
+
+    struct Consumer {
+        ConsumerStats stats;
+        uint64_t cursor = 0;      // 下一个要读取的序号
+        bool active = true;
+    };
+
+    // 消费者c放弃[c.cursor, until)范围内的槽位
+    void release_range(Consumer& c, uint64_t until);
+    void release_slot(uint64_t seq);
+
+    std::vector<Slot> slots;
+    std::deque<Consumer> consumers;  // deque：登记新消费者时不使已有引用失效
+    uint64_t write_seq = 0;       // 已推送的帧总数
+    bool is_flush = false;
+    std::mutex mtx;
+    std::condition_variable not_full;
+    std::condition_variable not_empty;
+};
+
+#endif //FFMPEGPROJECT_BROADCAST_RING_H
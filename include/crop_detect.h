@@ -0,0 +1,34 @@
+//
+// Created by Jianing on 2026/01/27.
+//
+
+#ifndef FFMPEGPROJECT_CROP_DETECT_H
+#define FFMPEGPROJECT_CROP_DETECT_H
+
+extern "C" {
+#include <libavutil/frame.h>
+}
+
+// 四边裁掉的像素数（均为偶数，4:2:0色度可整除）
+struct CropRect {
+    int top = 0, bottom = 0, left = 0, right = 0;
+    bool empty() const { return top == 0 && bottom == 0 && left == 0 && right == 0; }
+};
+
+// 黑边检测参数
+struct CropDetectOptions {
+    double sample_seconds = 60.0;  // 在片头这么长的范围内均匀取样（不足时取全片）
+    int samples = 12;              // 取样关键帧数（按关键帧索引seek，只解码关键帧）
+    int black_level = 24;          // 行/列的亮度均值不超过该值视为黑边
+    int round = 16;                // 裁剪后宽高向上取整到该倍数（宁可多留一点黑边）
+    int min_border = 8;            // 上下（或左右）合计小于该值时该方向不裁
+};
+
+// 预扫描：对取样帧逐行/逐列求亮度均值（SIMD内核）得到画面内容范围，取所有样本的并集
+// （只裁每个样本都是黑边的部分）。检测成功返回true，crop为空表示无需裁剪
+bool detect_black_borders(const char* input_file, const CropDetectOptions& opts, CropRect* crop);
+
+// 零拷贝裁剪：只调整data[]指针和宽高（av_frame_apply_cropping），成功返回0
+int apply_crop(AVFrame* frame, const CropRect& crop);
+
+#endif //FFMPEGPROJECT_CROP_DETECT_H
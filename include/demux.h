@@ -6,9 +6,24 @@
 #define FFMPEGPROJECT_DEMUX_H
 
 #include "common.h"
+#include "live_latency.h"
+#include <vector>
+#include <stdint.h>
+
+struct AVStream;
+
+// 解封装选项
+struct DemuxOptions {
+    bool pace = false;                   // 按视频dts以实时速度读取（文件输入模拟直播源）
+    LatencyTracker* latency = nullptr;   // 非空时登记每个视频Packet的采集时刻
+};
+
+// 流的关键帧索引（解封装器打开时已知的部分，时间基为流时间基，升序）。
+// 索引时间戳可能是dts，调用者需自行留出重排余量；须在解封装线程启动前调用（读包时索引还会增长）
+std::vector<int64_t> stream_keyframe_index(const AVStream* st);
 
 // 解封装线程函数声明
-void demux_thread(AVFormatContext* fmt_ctx, int video_stream_idx, int audio_stream_idx);
+void demux_thread(AVFormatContext* fmt_ctx, int video_stream_idx, int audio_stream_idx, DemuxOptions opts);
 
 
 #endif //FFMPEGPROJECT_DEMUX_H
@@ -0,0 +1,50 @@
+//
+// Created by Jianing on 2026/01/31.
+//
+
+#ifndef FFMPEGPROJECT_ENCODE_COST_H
+#define FFMPEGPROJECT_ENCODE_COST_H
+
+#include <string>
+#include <stdint.h>
+#include "encoder_profile.h"
+#include "crop_detect.h"
+
+// 编码开销预测参数
+struct CostPredictOptions {
+    int sample_frames = 60;                                  // 片中试编码的帧数
+    std::string json_file = "encode_cost.json";              // 预测结果（供调度器读取），空串表示不写
+    std::string history_file = "encode_cost_history.csv";    // 预测/实测记录（校准与误差统计），空串表示不用
+    int history_window = 20;                                 // 校准和误差统计取同一配置最近这么多条
+    CropRect crop;                                           // 与正式编码相同的裁剪
+};
+
+// 预测结果及所依据的信号
+struct CostEstimate {
+    std::string input;
+    std::string profile;
+    int width = 0, height = 0;             // 编码尺寸
+    double duration = 0;                   // 秒
+    int64_t frames = 0;                    // 预计编码帧数（源帧数）
+    double avg_packet_bytes = 0;           // 全片视频包平均字节数（源内容复杂度的代理）
+    double packet_bytes_cv = 0;            // 包大小变异系数（复杂度波动）
+    double sample_packet_bytes = 0;        // 试编码段的源包平均字节数
+    int sample_frames = 0;
+    double decode_cpu_per_frame = 0;       // 试编码段每帧CPU秒：解码 + 裁剪/缩放
+    double encode_cpu_per_frame = 0;       // 试编码段每帧CPU秒：编码
+    double complexity = 1.0;               // 全片相对试编码段的复杂度修正
+    double calibration = 1.0;              // 同一配置历史实测/预测的中位数
+    int calibration_samples = 0;
+    double predicted_cpu_seconds = 0;
+};
+
+// 预检：按编码尺寸和配置预测整片转码占用的CPU秒数。信号取自分辨率、时长、解封装得到的
+// 包大小统计（优先用容器索引，不解码），以及片中一小段实际解码/编码的每帧CPU时间；
+// 再乘以历史校准系数。成功时写入opts.json_file并返回true
+bool predict_encode_cost(const char* input_file, const EncoderProfile& profile, int width, int height,
+                         AVRational time_base, const CostPredictOptions& opts, CostEstimate* estimate);
+
+// 任务结束后记录实际CPU秒数：追加到历史文件，并输出该配置最近若干条的平均绝对百分比误差
+void record_encode_cost(const CostPredictOptions& opts, const CostEstimate& estimate, double actual_cpu_seconds);
+
+#endif //FFMPEGPROJECT_ENCODE_COST_H
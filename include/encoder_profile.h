@@ -0,0 +1,54 @@
+//
+// Created by Jianing on 2026/01/29.
+//
+
+#ifndef FFMPEGPROJECT_ENCODER_PROFILE_H
+#define FFMPEGPROJECT_ENCODER_PROFILE_H
+
+#include <string>
+#include <stdint.h>
+
+extern "C" {
+#include <libavutil/rational.h>
+#include <libavutil/pixfmt.h>
+}
+struct AVCodecContext;
+struct AVCodecParameters;
+
+// 码率控制方式
+enum class RateControl {
+    Bitrate,        // 平均码率（bit_rate）
+    ConstQuality,   // 恒定质量：编码器有crf选项时设crf，否则按固定量化参数（qscale）
+};
+
+// 编码配置：编码器、预设、码率控制、GOP、线程、B帧和私有选项。默认值即原先固定的MPEG4设置
+struct EncoderProfile {
+    std::string name = "mpeg4";
+    std::string codec = "mpeg4";         // 编码器名（avcodec_find_encoder_by_name），如mpeg4/libx264
+    std::string preset;                  // 编码器的preset私有选项，空表示不设
+    RateControl rate_control = RateControl::Bitrate;
+    int64_t bit_rate = 1000000;
+    int quality = 23;                    // ConstQuality时的crf/qscale
+    int gop_size = 10;
+    int max_b_frames = 0;                // B帧数：输出Packet的dts取自编码器，复用时按pts/dts分别换算
+    int threads = 1;                     // 编码器线程数，0表示由libavcodec按CPU核数决定
+    uint32_t codec_tag = 0;              // 0表示由封装器按codec_id选择
+    bool global_header = false;          // 参数集放进extradata（MP4中H.264/HEVC必须）
+    std::string options;                 // 其余选项，"key=value:key=value"，打开时解析为AVDictionary
+    AVColorRange color_range = AVCOL_RANGE_UNSPECIFIED;  // 输入帧的取值范围，按源设置（见yuv420p_color_range）
+};
+
+// 按名字取内置配置（返回拷贝，调用者可按任务再调整码率等），找不到时输出可用配置并返回false
+bool find_encoder_profile(const std::string& name, EncoderProfile* profile);
+
+// 直播低延迟：去掉B帧，编码器有tune选项时设zerolatency（libx264：无lookahead、按片多线程）
+void apply_low_latency(EncoderProfile* profile);
+
+// 按配置打开视频编码器（YUV420P输入），失败时输出错误并返回nullptr
+AVCodecContext* open_video_encoder(const EncoderProfile& profile, int width, int height, AVRational time_base);
+
+// 复用参数：按同一配置打开一次编码器，用avcodec_parameters_from_context导出
+// （codec_id/tag、尺寸、码率、extradata都与实际编码器一致），失败返回nullptr
+AVCodecParameters* make_encoder_params(const EncoderProfile& profile, int width, int height, AVRational time_base);
+
+#endif //FFMPEGPROJECT_ENCODER_PROFILE_H
@@ -0,0 +1,50 @@
+//
+// Created by Jianing on 2026/01/26.
+//
+
+#ifndef FFMPEGPROJECT_FRAME_DEDUP_H
+#define FFMPEGPROJECT_FRAME_DEDUP_H
+
+#include <stdint.h>
+
+extern "C" {
+#include <libavutil/frame.h>
+}
+
+// 重复帧消除参数
+struct DedupOptions {
+    bool enabled = false;
+    double threshold = 0.0;  // 每字节平均绝对差（0~255）不超过该值即视为重复，0表示只丢完全相同的帧
+    int max_run = 0;         // 最多连续丢弃的帧数（到达后保留一帧，便于播放器定位），0表示不限
+};
+
+// 重复帧检测：与上一个保留帧逐平面逐行求SAD（SIMD内核），超出阈值对应的总量即提前结束。
+// 和上一个"保留"的帧比较而非上一帧，缓慢渐变累计到阈值后仍会保留新帧
+class DuplicateFrameFilter {
+public:
+    explicit DuplicateFrameFilter(const DedupOptions& opts);
+    ~DuplicateFrameFilter();
+
+    DuplicateFrameFilter(const DuplicateFrameFilter&) = delete;
+    DuplicateFrameFilter& operator=(const DuplicateFrameFilter&) = delete;
+
+    // 按顺序送入每一帧，返回true表示应丢弃（与上一保留帧重复）
+    bool is_duplicate(const AVFrame* frame);
+
+    // 输入结束时调用：若最后一帧被丢弃则交出它（调用者负责释放），编码它以保证输出时长完整
+    AVFrame* take_tail();
+
+    int64_t dropped() const { return drop_count; }
+
+private:
+    // 与last_kept相比差异是否在阈值内
+    bool same_as_kept(const AVFrame* frame) const;
+
+    DedupOptions opts;
+    AVFrame* last_kept = nullptr;
+    AVFrame* last_dropped = nullptr;  // 最近一次丢弃的帧（仅当它是最后一帧时才用得上）
+    int run = 0;
+    int64_t drop_count = 0;
+};
+
+#endif //FFMPEGPROJECT_FRAME_DEDUP_H
@@ -0,0 +1,81 @@
+//
+// Created by Jianing on 2026/01/05.
+//
+
+#ifndef FFMPEGPROJECT_FRAME_POOL_H
+#define FFMPEGPROJECT_FRAME_POOL_H
+
+#include <mutex>
+#include <vector>
+#include <stddef.h>
+
+extern "C" {
+#include <libavutil/frame.h>
+#include <libavutil/buffer.h>
+}
+
+struct AVCodecContext;
+
+// 大页模式（仅Linux生效，其他平台按普通页处理）
+enum class HugePageMode {
+    None,         // 普通页
+    Transparent,  // 透明大页：2MB对齐分配 + madvise(MADV_HUGEPAGE)
+    HugeTLB       // hugetlbfs：mmap(MAP_HUGETLB)，失败时回退透明大页
+};
+
+struct FramePoolOptions {
+    int align = 64;                           // 行/平面起始地址对齐字节数
+    HugePageMode huge_page = HugePageMode::None;
+    bool prefault = true;                     // 分配后逐页预写，稳态解码不再缺页
+};
+
+// 帧缓冲池：按 分辨率/像素格式 维护一组AVBufferPool（每个平面一个），
+// 既可作为解码器的get_buffer2，也可直接给其他阶段分配输出帧
+class FramePool {
+public:
+    explicit FramePool(const FramePoolOptions& opts = FramePoolOptions());
+    ~FramePool();
+
+    FramePool(const FramePool&) = delete;
+    FramePool& operator=(const FramePool&) = delete;
+
+    // 新建某分辨率/格式的缓冲池时预分配（并预写）的缓冲区个数
+    void set_prewarm_count(int count);
+
+    // 为frame分配池化缓冲区（frame->width/height/format需已设置）
+    // aligned_w/aligned_h：编解码器要求的对齐尺寸，<=0时使用frame原尺寸
+    int get_buffer(AVFrame* frame, int aligned_w = 0, int aligned_h = 0);
+
+    // 挂到解码器上（需在avcodec_open2之前调用，占用codec_ctx->opaque）
+    void attach(AVCodecContext* codec_ctx);
+
+    // get_buffer2回调，codec_ctx->opaque指向FramePool
+    static int get_buffer2(AVCodecContext* codec_ctx, AVFrame* frame, int flags);
+
+private:
+    // 某一分辨率/格式对应的缓冲池
+    struct PoolSet {
+        int width = 0;
+        int height = 0;
+        int format = -1;
+        int linesize[4] = {0};
+        AVBufferPool* pools[4] = {nullptr};
+    };
+
+    PoolSet* find_or_create(int width, int height, int format, int extra_prewarm);
+    void prewarm(PoolSet* set, int count);
+
+#if FF_API_BUFFER_SIZE_T
+    static AVBufferRef* pool_alloc(void* opaque, int size);
+#else
+    static AVBufferRef* pool_alloc(void* opaque, size_t size);
+#endif
+    static void pool_free(void* opaque, uint8_t* data);
+
+    FramePoolOptions opts;
+    int prewarm_count = 0;
+    std::mutex mtx;
+    std::vector<PoolSet*> sets;  // 最近使用的缓冲池，超出上限时最旧的交给FFmpeg延迟释放
+};
+
+#endif //FFMPEGPROJECT_FRAME_POOL_H
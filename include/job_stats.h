@@ -0,0 +1,61 @@
+//
+// Created by Jianing on 2026/01/22.
+//
+
+#ifndef FFMPEGPROJECT_JOB_STATS_H
+#define FFMPEGPROJECT_JOB_STATS_H
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <chrono>
+#include <stdint.h>
+
+// 任务统计：各阶段按名字累计耗时/次数，任务结束时统一输出
+class JobStats {
+public:
+    struct Entry {
+        double seconds = 0;      // 累计耗时
+        double max_seconds = 0;  // 单次最大耗时
+        int64_t count = 0;       // 次数（帧数/调用数）
+    };
+
+    // 累计一次耗时
+    void add_time(const std::string& key, double seconds, int64_t count = 1);
+    // 只累计次数（无耗时的计数项）
+    void add_count(const std::string& key, int64_t count);
+
+    std::map<std::string, Entry> snapshot();
+    void print();
+    void reset();
+
+private:
+    std::mutex mtx;
+    std::map<std::string, Entry> entries;
+};
+
+// 作用域计时：析构时把经过的时间记到stats[key]
+class ScopedTimer {
+public:
+    ScopedTimer(JobStats& stats, std::string key)
+            : stats(stats), key(std::move(key)), start(std::chrono::steady_clock::now()) {}
+    ~ScopedTimer() {
+        stats.add_time(key, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    JobStats& stats;
+    std::string key;
+    std::chrono::steady_clock::time_point start;
+};
+
+// 本进程累计占用的CPU时间（所有线程的用户态+内核态，秒）
+double process_cpu_seconds();
+
+// 全局任务统计（定义在job_stats.cpp）
+extern JobStats g_job_stats;
+
+#endif //FFMPEGPROJECT_JOB_STATS_H
@@ -0,0 +1,13 @@
+//
+// Created by Jianing on 2026/02/03.
+//
+
+#ifndef FFMPEGPROJECT_JSON_UTIL_H
+#define FFMPEGPROJECT_JSON_UTIL_H
+
+#include <string>
+
+// JSON字符串转义：引号、反斜杠和控制字符（Windows路径里的反斜杠等），返回值不含两侧引号
+std::string json_escape(const std::string& s);
+
+#endif //FFMPEGPROJECT_JSON_UTIL_H
@@ -0,0 +1,58 @@
+//
+// Created by Jianing on 2026/02/03.
+//
+
+#ifndef FFMPEGPROJECT_KEYFRAME_SAMPLER_H
+#define FFMPEGPROJECT_KEYFRAME_SAMPLER_H
+
+#include <stdint.h>
+
+struct AVFormatContext;
+struct AVCodecContext;
+struct AVStream;
+struct AVPacket;
+struct AVFrame;
+
+// 流时长（流时间基），流上没有时长时使用容器时长，都未知时返回0
+int64_t stream_duration(const AVFormatContext* fmt_ctx, const AVStream* stream);
+
+// seek到目标时间之前最近的关键帧并只解码该关键帧，key_pts为该关键帧的pts（没有pts时取dts）
+bool decode_keyframe_at(AVFormatContext* fmt_ctx, AVCodecContext* dec_ctx, int stream_idx,
+                        int64_t target_ts, AVPacket* pkt, AVFrame* frame, int64_t* key_pts);
+
+// 单个取样点的结果
+enum class KeyframeSample {
+    Done,       // 取样点已用完
+    Failed,     // seek失败或其后没有关键帧，frame未写入
+    Decoded,    // frame为新解码的关键帧
+    Repeated,   // 与上一个成功的取样点落在同一关键帧（同一GOP），frame内容相同
+};
+
+// 均匀取样：在[start, start + span)（流时间基）内取count个区间的中点（避免全部落在片头），
+// 逐个解码其前最近的关键帧。缩略图与黑边检测共用；解码器一般设AVDISCARD_NONKEY
+class KeyframeSampler {
+public:
+    KeyframeSampler(AVFormatContext* fmt_ctx, AVCodecContext* dec_ctx, int stream_idx,
+                    int64_t start, int64_t span, int count);
+    ~KeyframeSampler();
+    KeyframeSampler(const KeyframeSampler&) = delete;
+    KeyframeSampler& operator=(const KeyframeSampler&) = delete;
+
+    // 取下一个取样点的关键帧到frame（Decoded/Repeated时由调用者unref）
+    KeyframeSample next(AVFrame* frame);
+    // 最近一次成功取样的关键帧pts，未知为AV_NOPTS_VALUE
+    int64_t key_pts() const { return last_key_pts; }
+
+private:
+    AVFormatContext* fmt_ctx;
+    AVCodecContext* dec_ctx;
+    int stream_idx;
+    int64_t start;
+    int64_t span;
+    int count;
+    int index = 0;
+    int64_t last_key_pts;
+    AVPacket* pkt;
+};
+
+#endif //FFMPEGPROJECT_KEYFRAME_SAMPLER_H
@@ -0,0 +1,80 @@
+//
+// Created by Jianing on 2026/02/02.
+//
+
+#ifndef FFMPEGPROJECT_LIVE_LATENCY_H
+#define FFMPEGPROJECT_LIVE_LATENCY_H
+
+#include <map>
+#include <mutex>
+#include <chrono>
+#include <vector>
+#include <stdint.h>
+
+struct AVFrame;
+
+// 延迟直方图：按对数分桶（相邻桶上界相差10%，50us到约12s），估计p50/p99，最大值精确记录
+class LatencyHistogram {
+public:
+    LatencyHistogram();
+
+    void add(double seconds);
+    int64_t count() const { return total; }
+    double percentile(double p) const;  // 所在桶的上界（秒）
+    double max() const { return max_seconds; }
+
+private:
+    std::vector<int64_t> buckets;
+    int64_t total = 0;
+    double max_seconds = 0;
+};
+
+// 逐帧端到端延迟跟踪：解封装读到视频Packet、解码输出、送入编码器、编码输出、复用写出五处打单调时钟戳，
+// 统计相邻阶段之间和整体（采集→写盘）的延迟直方图。
+// 解码帧起时间戳随帧的opaque_ref经过环形缓冲区/滤镜/缩放；Packet在FFmpeg 4.4里带不了opaque_ref，
+// 解封装→解码按源时间戳、编码→复用按编码pts对应，对不上的记录最多各保留1024条。各阶段在不同线程调用
+class LatencyTracker {
+public:
+    enum Stage { Demux, DecodeOut, EncodeIn, EncodeOut, MuxWrite, StageCount };
+
+    // target_seconds>0时整体延迟超过该值的帧单独计数并告警；每report_interval帧输出一次各阶段统计
+    explicit LatencyTracker(double target_seconds = 0, int64_t report_interval = 250);
+
+    // 解封装：读到源时间戳为src_ts（流时间基）的视频Packet
+    void on_capture(int64_t src_ts);
+    // 解码输出：按帧的源时间戳取回采集时刻，连同解码时刻挂到frame->opaque_ref
+    void on_decoded(AVFrame* frame);
+    // 送入编码器：frame为带opaque_ref的输入帧，enc_pts为它在编码器中的pts
+    void on_encode(const AVFrame* frame, int64_t enc_pts);
+    // 不经过on_encode跟踪、按设计不统计的帧（并行GOP编码、重复帧消除补编的末帧），单独计数
+    void on_excluded(int64_t count = 1);
+    // 编码输出：编码pts（编码器时间基）的Packet出编码器
+    void on_encoded(int64_t enc_pts);
+    // 复用：编码pts的Packet已写出
+    void on_write(int64_t enc_pts);
+
+    // 输出各阶段和整体延迟的p50/p99/max
+    void print();
+
+private:
+    using Clock = std::chrono::steady_clock;
+    struct Stamps {
+        Clock::time_point at[StageCount];
+    };
+    static const char* const interval_names[StageCount];
+
+    void print_locked();
+
+    std::mutex mtx;
+    double target;
+    int64_t report_interval;
+    std::map<int64_t, Clock::time_point> captured;   // 源时间戳 → 采集时刻
+    std::map<int64_t, Stamps> encoding;              // 编码pts → 已有的时间戳（按pts精确对应，有B帧也成立）
+    LatencyHistogram intervals[StageCount];          // [i]为阶段i-1到阶段i；[0]为整体
+    int64_t frames = 0;
+    int64_t over_target = 0;
+    int64_t untracked = 0;     // 找不到采集记录的帧（滤镜改变了时间戳等）
+    int64_t excluded = 0;      // 按设计不统计的帧
+};
+
+#endif //FFMPEGPROJECT_LIVE_LATENCY_H
@@ -7,12 +7,27 @@
 
 #include <string>
 #include "common.h"
+#include "live_latency.h"
+extern "C" {
+#include <libavutil/rational.h>
+}
 struct AVCodecParameters;
 
-// 复用线程（入参：输出文件路径、视频/音频编码参数）
+// 复用选项
+struct MuxOptions {
+    // 直播低延迟：写分片MP4（空moov + 每个Packet写完即成一个fragment，写入过程中文件即可读），
+    // 不经交织缓冲直接写出，每个Packet写完立即刷到文件
+    bool low_latency = false;
+    LatencyTracker* latency = nullptr;   // 非空时每个Packet写出后打复用时间戳，完成该帧的逐阶段延迟统计
+};
+
+// 复用线程（入参：输出文件路径、视频/音频编码参数、视频Packet时间基即编码器time_base、视频Packet来源队列、复用选项）
 void mux_thread(const std::string& output_file,
                 AVCodecParameters* video_enc_par,
-                AVCodecParameters* audio_enc_par);
+                AVCodecParameters* audio_enc_par,
+                AVRational video_pkt_time_base,
+                DeepCopyPacketQueue* video_pkt_queue,
+                MuxOptions opts);
 
 
 #endif //FFMPEGPROJECT_MUX_H
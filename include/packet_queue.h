@@ -42,6 +42,12 @@ public:
         return true;
     }
 
+    // 当前积压的Packet数
+    size_t size() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return queue.size();
+    }
+
     // 判断队列是否为空
     bool is_empty() {
         std::lock_guard<std::mutex> lock(mtx);
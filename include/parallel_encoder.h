@@ -0,0 +1,25 @@
+//
+// Created by Jianing on 2026/01/28.
+//
+
+#ifndef FFMPEGPROJECT_PARALLEL_ENCODER_H
+#define FFMPEGPROJECT_PARALLEL_ENCODER_H
+
+#include "videoencoder.h"
+
+// 并行GOP编码参数
+struct ParallelEncodeOptions {
+    // 输入/输出队列、码率、GOP长度、场景切换（开启时按场景切换点切分GOP）；
+    // quality/dedup/src_time_base在并行模式下不使用
+    VideoEncodeOptions encode;
+    int workers = 4;             // 编码器实例数（各自一个线程）
+    int max_inflight_gops = 0;   // 同时在途（排队 + 编码中 + 等待重排）的任务上限（一个任务通常为一个GOP），0表示2*workers
+};
+
+// 并行GOP编码线程：把输入帧切成封闭GOP（首帧强制I帧、无B帧），轮流交给workers个
+// 独立的编码器实例（encode.profile），各GOP的Packet经重排缓冲按GOP顺序推入encode.out_queue。
+// 入参与video_encode_thread相同，可直接替换
+void parallel_encode_thread(AVCodecParameters* src_codec_par, AVRational output_time_base,
+                            ParallelEncodeOptions opts);
+
+#endif //FFMPEGPROJECT_PARALLEL_ENCODER_H
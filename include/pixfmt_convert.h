@@ -0,0 +1,32 @@
+//
+// Created by Jianing on 2026/01/18.
+//
+
+#ifndef FFMPEGPROJECT_PIXFMT_CONVERT_H
+#define FFMPEGPROJECT_PIXFMT_CONVERT_H
+
+#include "frame_pool.h"
+
+extern "C" {
+#include <libavutil/frame.h>
+#include <libavutil/pixfmt.h>
+}
+
+// 是否有到YUV420P的快速转换（NV12、YUV422P/YUVJ422P、YUYV422、YUVJ420P）
+bool can_convert_to_yuv420p(AVPixelFormat fmt);
+
+// 把src转换为YUV420P写入dst（dst需为空帧）；pool非空时输出缓冲从中分配。
+// YUVJ420P只改标记为YUV420P+全范围，直接引用源帧不拷贝。成功返回0
+int convert_to_yuv420p(const AVFrame* src, AVFrame* dst, FramePool* pool = nullptr);
+
+// 源（像素格式fmt、标记的取值范围range）转换为YUV420P后的取值范围：YUVJ格式或已标记全范围时为AVCOL_RANGE_JPEG。
+// 编码器在收到第一帧之前打开，须据此设置EncoderProfile::color_range，复用参数和容器里的范围标记才正确
+AVColorRange yuv420p_color_range(AVPixelFormat fmt, AVColorRange range);
+
+// 各SIMD内核（格式转换、盒式缩小、SAD/SSE、SSIM统计、逐列累加）与C参考实现逐字节比对（含非对齐长度的尾部），全部一致返回true
+bool pixfmt_kernels_self_check();
+
+// 基准：对每种源格式分别用各内核和swscale转换width x height帧iterations次，输出GB/s
+void pixfmt_benchmark(int width, int height, int iterations);
+
+#endif //FFMPEGPROJECT_PIXFMT_CONVERT_H
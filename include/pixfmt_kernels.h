@@ -0,0 +1,53 @@
+//
+// Created by Jianing on 2026/01/18.
+//
+
+#ifndef FFMPEGPROJECT_PIXFMT_KERNELS_H
+#define FFMPEGPROJECT_PIXFMT_KERNELS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+// 转YUV420P、整数倍缩小、帧差/黑边分析及质量评估用到的行级内核（各实现与C版逐字节一致）
+struct PixFmtKernels {
+    const char* name;  // "c" / "sse4" / "avx2" / "neon"
+
+    // 交错UV行（NV12色度）拆成U、V两行，n为色度样本数
+    void (*deinterleave_uv)(const uint8_t* uv, uint8_t* u, uint8_t* v, int n);
+
+    // 两行逐字节取平均 (a + b + 1) >> 1（4:2:2色度纵向下采样）
+    void (*average_rows)(const uint8_t* a, const uint8_t* b, uint8_t* dst, int n);
+
+    // 两行YUYV422 → 两行Y + 一行U、V（色度取两行平均），width为像素宽度
+    void (*yuyv_to_yuv420)(const uint8_t* row0, const uint8_t* row1,
+                           uint8_t* y0, uint8_t* y1, uint8_t* u, uint8_t* v, int width);
+
+    // 2:1盒式缩小：两行源 → 一行输出，dst[x] = (2x2块之和 + 2) >> 2，dst_w为输出宽度
+    void (*box2_row)(const uint8_t* r0, const uint8_t* r1, uint8_t* dst, int dst_w);
+
+    // 4:1盒式缩小：四行源 → 一行输出，dst[x] = (4x4块之和 + 8) >> 4
+    void (*box4_row)(const uint8_t* r0, const uint8_t* r1, const uint8_t* r2, const uint8_t* r3,
+                     uint8_t* dst, int dst_w);
+
+    // 两行逐字节绝对差之和（SAD），用于场景切换/重复帧检测
+    uint32_t (*sad_row)(const uint8_t* a, const uint8_t* b, int n);
+
+    // 两行逐字节差的平方和（SSE），用于PSNR
+    uint64_t (*sse_row)(const uint8_t* a, const uint8_t* b, int n);
+
+    // SSIM统计：4行高条带内连续blocks个4x4块，每块求 Σa、Σb、Σ(a²+b²)、Σab 写入sums[i][0..3]
+    void (*ssim_4x4_row)(const uint8_t* a, ptrdiff_t a_stride, const uint8_t* b, ptrdiff_t b_stride,
+                         int32_t (*sums)[4], int blocks);
+
+    // 逐列累加：acc[i] += row[i]，用于按列求亮度均值（黑边检测）
+    void (*accumulate_row)(const uint8_t* row, uint32_t* acc, int n);
+};
+
+// 按av_get_cpu_flags选择的最优实现（首次调用时确定）
+const PixFmtKernels& pixfmt_kernels();
+
+// 当前CPU上可用的全部实现（C版在最前），用于一致性校验和基准测试
+std::vector<const PixFmtKernels*> pixfmt_kernels_available();
+
+#endif //FFMPEGPROJECT_PIXFMT_KERNELS_H
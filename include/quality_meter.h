@@ -0,0 +1,93 @@
+//
+// Created by Jianing on 2026/01/25.
+//
+
+#ifndef FFMPEGPROJECT_QUALITY_METER_H
+#define FFMPEGPROJECT_QUALITY_METER_H
+
+#include <map>
+#include <string>
+#include <fstream>
+#include <stdint.h>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+// 质量评估参数
+struct QualityMeterOptions {
+    bool enabled = false;
+    int sample_interval = 1;                        // 每N帧评估一帧（重建仍逐包解码，只有打分抽样）
+    std::string frame_csv = "quality_frames.csv";   // 逐帧分数，空串表示不写
+    std::string gop_csv = "quality_gops.csv";       // 逐GOP汇总，空串表示不写
+    bool report = true;                             // 输出启用/汇总日志并计入g_job_stats（批量试编码时关闭）
+};
+
+// 单帧的PSNR/SSIM
+struct FrameQuality {
+    double psnr_y = 0, psnr_u = 0, psnr_v = 0, psnr = 0;  // dB，完全一致时记为kMaxPsnr
+    double ssim_y = 0, ssim = 0;                          // ssim为三平面按像素数加权
+};
+
+// 编码质量评估：保留送入编码器的源帧引用，把编码输出的Packet在进程内解码得到重建帧，
+// 按pts配对后用SIMD内核计算PSNR/SSIM，输出逐帧和逐GOP分数。由编码线程同步调用
+class QualityMeter {
+public:
+    static constexpr double kMaxPsnr = 100.0;
+
+    explicit QualityMeter(const QualityMeterOptions& opts);
+    ~QualityMeter();
+
+    QualityMeter(const QualityMeter&) = delete;
+    QualityMeter& operator=(const QualityMeter&) = delete;
+
+    // 按编码器参数打开对应的解码器（编码器打开之后调用）
+    bool open(const AVCodecContext* enc_ctx);
+    bool is_open() const { return dec_ctx != nullptr; }
+
+    // 送入编码器之前调用：抽中的帧保留一份引用（pts需已设置为编码器时间基）
+    void add_source(const AVFrame* frame);
+    // 每个编码输出Packet（时间戳仍为编码器时间基）
+    void on_packet(const AVPacket* pkt);
+    // 编码结束后冲刷解码器、结束最后一个GOP并输出汇总
+    void finish();
+
+    // 已评估帧数及平均分（finish之后为全片结果）
+    int64_t scored_frames() const { return total_scored; }
+    double average_psnr() const { return total_scored > 0 ? total_psnr / total_scored : 0.0; }
+    double average_ssim() const { return total_scored > 0 ? total_ssim / total_scored : 0.0; }
+
+    // 整幅平面的PSNR/SSIM计算（YUV420P，两帧尺寸须一致）
+    static FrameQuality compare(const AVFrame* ref, const AVFrame* dist);
+
+private:
+    struct GopAccum {
+        int64_t index = -1;
+        int64_t first_frame = 0;
+        int frames = 0;
+        int scored = 0;
+        int64_t bytes = 0;
+        double psnr_sum = 0, psnr_min = kMaxPsnr;
+        double ssim_sum = 0, ssim_min = 1.0;
+    };
+
+    void receive_frames();
+    void on_reconstructed(const AVFrame* frame);
+    void close_gop();
+
+    QualityMeterOptions opts;
+    AVCodecContext* dec_ctx = nullptr;
+    AVFrame* recon = nullptr;
+    std::map<int64_t, AVFrame*> sources;  // pts → 源帧引用
+    std::ofstream frame_out, gop_out;
+    bool finished = false;
+    int64_t source_count = 0;
+    int64_t recon_count = 0;
+    GopAccum gop;
+    // 全片汇总
+    int64_t total_scored = 0;
+    double total_psnr = 0, total_ssim = 0;
+    double total_psnr_min = kMaxPsnr;
+};
+
+#endif //FFMPEGPROJECT_QUALITY_METER_H
@@ -0,0 +1,44 @@
+//
+// Created by Jianing on 2026/01/30.
+//
+
+#ifndef FFMPEGPROJECT_QUALITY_SEARCH_H
+#define FFMPEGPROJECT_QUALITY_SEARCH_H
+
+#include <vector>
+#include <stdint.h>
+#include "encoder_profile.h"
+#include "crop_detect.h"
+
+extern "C" {
+#include <libavutil/frame.h>
+}
+
+// 按内容选择码率/质量参数的搜索选项
+struct QualitySearchOptions {
+    int samples = 6;             // 取样片段数（按关键帧索引在全片均匀选取）
+    int sample_frames = 30;      // 每段从关键帧起试编码的帧数
+    int workers = 4;             // 同时处理的片段数（每段一个线程、一份帧缓存）
+    double target_ssim = 0.95;   // 各段平均SSIM须达到该值
+    double target_psnr = 0.0;    // >0时各段平均PSNR（dB）也须达到
+    // Bitrate模式的候选码率，从低到高
+    std::vector<int64_t> bit_rates = {250000, 400000, 600000, 900000, 1300000, 2000000, 3000000, 4500000};
+    // ConstQuality模式的候选crf/qscale，从低质量到高质量；空表示mpeg4按qscale、其余按crf自动取值
+    std::vector<int> qualities;
+    CropRect crop;               // 与正式编码相同的裁剪
+};
+
+// 按关键帧索引在全片均匀取samples段，多段并行：每段裁剪/缩放到编码尺寸后依次按每个候选点试编码，
+// 进程内解码重建计算PSNR/SSIM，选出各段平均满足目标的最低候选点写回profile（bit_rate或quality）。
+// 候选点都达不到目标时取最高一档；读取/解码失败返回false且profile不变。
+// 不经过用户滤镜图，只做裁剪和缩放
+bool search_encode_quality(const char* input_file, int width, int height, AVRational time_base,
+                           const QualitySearchOptions& opts, EncoderProfile* profile);
+
+// 取样解码：独立打开输入，seek到start_ts（流时间基）之前最近的关键帧，解码frame_count帧，
+// 裁剪并缩放为width x height的YUV420P追加到frames（调用者释放）。packet_bytes非空时累加读到的视频包字节数。
+// 得到至少一帧返回true；各线程可同时调用
+bool decode_sample_frames(const char* input_file, int64_t start_ts, int frame_count, int width, int height,
+                          const CropRect& crop, std::vector<AVFrame*>* frames, int64_t* packet_bytes = nullptr);
+
+#endif //FFMPEGPROJECT_QUALITY_SEARCH_H
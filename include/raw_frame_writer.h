@@ -0,0 +1,63 @@
+//
+// Created by Jianing on 2026/01/10.
+//
+
+#ifndef FFMPEGPROJECT_RAW_FRAME_WRITER_H
+#define FFMPEGPROJECT_RAW_FRAME_WRITER_H
+
+#include <string>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include "ring_buffer.h"
+
+extern "C" {
+#include <libavutil/rational.h>
+}
+
+// 一段待写出的连续内存
+struct RawIoVec {
+    const uint8_t* base;
+    size_t len;
+};
+
+// 原始帧导出（.yuv/.y4m）：调用方只增加帧引用计数入队，独立写线程负责落盘
+// - 队列有界，写盘跟不上时write_frame阻塞（背压），不会无限占用内存
+// - 每帧一次writev：行宽与linesize相等的平面整块写出，否则逐行聚合
+// - 支持所有非硬件/非调色板像素格式；Y4M仅支持其规范中定义的格式
+class RawFrameWriter {
+public:
+    explicit RawFrameWriter(uint32_t queue_capacity = 8);
+    ~RawFrameWriter();
+
+    RawFrameWriter(const RawFrameWriter&) = delete;
+    RawFrameWriter& operator=(const RawFrameWriter&) = delete;
+
+    // y4m=true时在第一帧前写入YUV4MPEG2头，frame_rate用于头中的F字段
+    bool open(const std::string& filename, bool y4m, AVRational frame_rate);
+
+    // 入队一帧（引用计数，不拷贝像素）；队列满时阻塞
+    bool write_frame(const AVFrame* frame);
+
+    // 等待写线程写完队列中剩余帧并关闭文件
+    void close();
+
+private:
+    void writer_loop();
+    bool write_one(const AVFrame* frame);
+    bool write_y4m_header(const AVFrame* frame);
+    bool write_all(const std::vector<RawIoVec>& vecs);
+
+    RingBuffer<AVFrame*> queue;
+    std::thread writer;
+    std::string filename;
+    int fd = -1;
+    bool y4m = false;
+    bool header_written = false;
+    std::atomic<bool> failed{false};  // 写线程出错后调用方不再入队
+    AVRational frame_rate = {25, 1};
+    int frame_count = 0;
+    std::vector<uint8_t> staging;  // 不支持writev的平台上用于合并成一次写
+};
+
+#endif //FFMPEGPROJECT_RAW_FRAME_WRITER_H
@@ -0,0 +1,74 @@
+//
+// Created by Jianing on 2026/01/12.
+//
+
+#ifndef FFMPEGPROJECT_RAW_VIDEO_SOURCE_H
+#define FFMPEGPROJECT_RAW_VIDEO_SOURCE_H
+
+#include <string>
+#include <vector>
+#include "ring_buffer.h"
+
+extern "C" {
+#include <libavutil/pixfmt.h>
+#include <libavutil/rational.h>
+#include <libavutil/buffer.h>
+}
+
+struct AVCodecParameters;
+
+// 原始视频输入参数（.y4m从文件头解析，以下字段仅裸.yuv需要）
+struct RawVideoSourceOptions {
+    std::string filename;
+    int width = 0;
+    int height = 0;
+    AVPixelFormat pix_fmt = AV_PIX_FMT_YUV420P;
+    AVRational frame_rate = {25, 1};
+};
+
+// 内存映射的原始视频源（编码器基准测试用）：
+// 整个文件mmap到内存，每帧AVFrame的data直接指向映射区，
+// 通过共享的AVBufferRef持有映射，最后一帧释放后才解除映射，全程无解码、无拷贝
+class RawVideoSource {
+public:
+    RawVideoSource() = default;
+    ~RawVideoSource();
+
+    RawVideoSource(const RawVideoSource&) = delete;
+    RawVideoSource& operator=(const RawVideoSource&) = delete;
+
+    bool open(const RawVideoSourceOptions& opts);
+    void close();
+
+    // 填充视频参数（供编码器/复用器使用）
+    void fill_codec_par(AVCodecParameters* par) const;
+
+    int frame_count() const { return static_cast<int>(frame_offsets.size()); }
+    AVRational get_frame_rate() const { return frame_rate; }
+
+    // 零拷贝封装第index帧，pts由调用方设置
+    bool wrap_frame(int index, AVFrame* frame) const;
+
+    // 循环loops遍，把所有帧推入out，结束后发送刷新信号
+    void run(RingBuffer<AVFrame*>& out, int loops) const;
+
+private:
+    bool parse_y4m();
+
+    AVBufferRef* mapping = nullptr;  // 持有整个文件映射
+    const uint8_t* base = nullptr;
+    size_t file_size = 0;
+    int width = 0;
+    int height = 0;
+    AVPixelFormat pix_fmt = AV_PIX_FMT_NONE;
+    AVColorRange color_range = AVCOL_RANGE_UNSPECIFIED;
+    AVRational frame_rate = {25, 1};
+    AVRational sample_aspect_ratio = {0, 1};
+    size_t frame_size = 0;
+    std::vector<size_t> frame_offsets;  // 每帧像素数据在文件中的起始偏移
+};
+
+// 原始视频源线程：替代 demux + 解码，直接向g_video_frame_ringbuf供帧
+void raw_video_source_thread(const RawVideoSource* source, int loops);
+
+#endif //FFMPEGPROJECT_RAW_VIDEO_SOURCE_H
@@ -0,0 +1,65 @@
+//
+// Created by Jianing on 2026/02/01.
+//
+
+#ifndef FFMPEGPROJECT_REALTIME_EFFORT_H
+#define FFMPEGPROJECT_REALTIME_EFFORT_H
+
+#include <vector>
+#include <chrono>
+#include <stdint.h>
+#include "encoder_profile.h"
+
+// 实时模式：编码须跟上墙钟，按落后程度和输入积压在GOP边界切换编码强度
+struct RealtimeOptions {
+    bool enabled = false;
+    double late_high = 0.5;       // 落后墙钟超过该秒数且仍在增加时降一档
+    double late_low = 0.1;        // 落后不超过该秒数才考虑升档
+    double backlog_high = 0.75;   // 输入缓冲区占用比例达到该值且落后在增加时提前降档
+    double backlog_low = 0.25;    // 占用比例不超过该值（或落后在减少）时允许升档
+    int hold_gops = 2;            // 切换后至少保持这么多个GOP，避免来回抖动
+    int log_interval_gops = 10;   // 每隔这么多个GOP输出一次落后情况
+};
+
+// 编码强度档位：第0档即原配置，之后逐档减少运动估计/宏块决策的开销。
+// 只改不影响码流头（SPS/PPS/VOL）、B帧数和参考帧数的选项，线程数也不变（会写进mpeg4的VOL）；
+// 换档时仍会比对extradata，不一致就不切换。编码器没有已知的档位选项时只有第0档
+std::vector<EncoderProfile> make_effort_levels(const EncoderProfile& base);
+
+// 档位控制：每帧记录源时间和输入积压，GOP边界给出下一段使用的档位
+class EffortController {
+public:
+    EffortController(const RealtimeOptions& opts, int level_count);
+
+    // 每帧送编码前调用：src_seconds为该帧源时间（秒，任意起点），backlog/capacity为输入缓冲区占用
+    void on_frame(double src_seconds, uint32_t backlog, uint32_t capacity);
+
+    // GOP边界调用：返回下一个GOP的档位（与level()相同表示不变），并清空本GOP的统计
+    int on_gop_boundary();
+
+    int level() const { return current; }
+    double max_lateness() const { return worst_late; }
+    int changes() const { return change_count; }
+
+private:
+    RealtimeOptions opts;
+    int level_count;
+    int current = 0;
+    int hold = 0;                  // 剩余保持GOP数
+    int change_count = 0;
+    int64_t gop_index = 0;
+
+    bool started = false;
+    std::chrono::steady_clock::time_point wall_start;
+    double src_start = 0;
+
+    // 当前GOP的统计
+    int gop_frames = 0;
+    double gop_late_peak = 0;
+    double gop_late_last = 0;
+    double gop_backlog_sum = 0;
+    double prev_gop_late = 0;      // 上一GOP结束时的落后秒数（判断趋势）
+    double worst_late = 0;
+};
+
+#endif //FFMPEGPROJECT_REALTIME_EFFORT_H
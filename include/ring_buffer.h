@@ -4,6 +4,9 @@
 #include <mutex>
 #include <condition_variable>
 #include <vector>
+#include <atomic>
+#include <chrono>
+#include <thread>
 #include <stdint.h>
 #include <iostream>  // 仅保留cout/cerr日志
 
@@ -22,16 +25,29 @@ private:
     uint32_t capacity;              // 最大容量
     uint32_t read_idx = 0;          // 读索引
     uint32_t write_idx = 0;         // 写索引
-    uint32_t count = 0;             // 当前元素数
-    std::mutex mtx;                 // 互斥锁
+    std::atomic<uint32_t> count{0}; // 当前元素数（自旋等待时不加锁读取）
+    mutable std::mutex mtx;         // 互斥锁（size()等const查询也要加锁）
     std::condition_variable not_full;  // 生产者等待（非满）
     std::condition_variable not_empty; // 消费者等待（非空）
-    bool is_flush = false;          // 刷新/退出标记
+    std::atomic<bool> is_flush{false};  // 刷新/退出标记
+    uint32_t spin_us = 0;           // 阻塞等待前的自旋时长（微秒），0表示直接阻塞
 
     // 判空/判满（私有内联函数）
     bool is_empty() const { return count == 0; }
     bool is_full() const { return count == capacity; }
 
+    // 低延迟交接：在条件变量上睡眠之前先自旋等待条件成立（不持锁），省去唤醒的调度延迟
+    template <typename Pred>
+    void spin_until(Pred pred) const {
+        if (spin_us == 0 || pred()) {
+            return;
+        }
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(spin_us);
+        while (!pred() && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::yield();
+        }
+    }
+
     // 初始化单个元素（AVFrame*/AVPacket*分配有效内存，避免野指针）
     void init_element(T& elem) {
         if constexpr (std::is_same_v<T, AVFrame*>) {
@@ -109,6 +125,7 @@ public:
 
     // 推送元素（阻塞，直到缓冲区非满/收到退出信号）
     bool push(const T& data) {
+        spin_until([this]() { return !is_full() || is_flush; });
         std::unique_lock<std::mutex> lock(mtx);
 
         // 等待缓冲区非满
@@ -130,8 +147,50 @@ public:
         return true;
     }
 
+    // 非阻塞推送：缓冲区满或已刷新时不推入，返回false
+    bool try_push(const T& data) {
+        std::unique_lock<std::mutex> lock(mtx);
+        if (is_full() || is_flush) {
+            return false;
+        }
+        if (!copy_element(buffer[write_idx], data)) {
+            return false;
+        }
+        write_idx = (write_idx + 1) % capacity;
+        count++;
+        not_empty.notify_one();
+        return true;
+    }
+
+    // 推送（不阻塞）：缓冲区满时先丢弃最旧的元素腾出位置，*dropped表示是否丢弃了元素
+    bool push_drop_oldest(const T& data, bool* dropped) {
+        std::unique_lock<std::mutex> lock(mtx);
+        *dropped = false;
+        if (is_flush) {
+            return false;
+        }
+        if (is_full()) {
+            if constexpr (std::is_same_v<T, AVFrame*>) {
+                av_frame_unref(buffer[read_idx]);
+            } else if constexpr (std::is_same_v<T, AVPacket*>) {
+                av_packet_unref(buffer[read_idx]);
+            }
+            read_idx = (read_idx + 1) % capacity;
+            count--;
+            *dropped = true;
+        }
+        if (!copy_element(buffer[write_idx], data)) {
+            return false;
+        }
+        write_idx = (write_idx + 1) % capacity;
+        count++;
+        not_empty.notify_one();
+        return true;
+    }
+
     // 取出元素（阻塞，直到缓冲区非空/收到退出信号）
     bool pop(T& data) {
+        spin_until([this]() { return !is_empty() || is_flush; });
         std::unique_lock<std::mutex> lock(mtx);
 
         // 等待缓冲区非空
@@ -185,6 +244,28 @@ public:
         std::cout << "[RingBuffer] 提示：缓冲区已重置！" << std::endl;
     }
 
+    // 修改容量（数据清空，只能在没有线程使用缓冲区时调用，如直播模式在启动线程前改小队列）
+    void resize(uint32_t cap) {
+        std::unique_lock<std::mutex> lock(mtx);
+        for (auto& elem : buffer) {
+            free_element(elem);
+        }
+        capacity = cap > 0 ? cap : 1;
+        buffer.resize(capacity);
+        for (auto& elem : buffer) {
+            init_element(elem);
+        }
+        read_idx = 0;
+        write_idx = 0;
+        count = 0;
+        is_flush = false;
+    }
+
+    // 设置阻塞前的自旋时长（微秒），同样在启动线程前调用
+    void set_spin_wait(uint32_t us) {
+        spin_us = us;
+    }
+
     // 析构函数：彻底释放所有内存（修复内存泄漏）
     ~RingBuffer() {
         std::unique_lock<std::mutex> lock(mtx);
@@ -195,7 +276,7 @@ public:
         std::cout << "[RingBuffer] 提示：缓冲区已析构，内存释放完成！" << std::endl;
     }
 
-    // 获取当前元素数量（调试用）
+    // 获取当前元素数量（实时模式按它判断输入积压）
     uint32_t size() const {
         std::unique_lock<std::mutex> lock(mtx);
         return count;
@@ -210,5 +291,7 @@ public:
 // 全局环形缓冲区声明（按需调整类型/容量）
 extern RingBuffer<AVFrame*> g_video_frame_ringbuf;
 extern RingBuffer<AVFrame*> g_audio_frame_ringbuf;
+extern RingBuffer<AVFrame*> g_video_scaled_frame_ringbuf;  // 缩放阶段输出（启用缩放时编码器从这里取帧）
+extern RingBuffer<AVFrame*> g_video_filtered_frame_ringbuf;  // 滤镜阶段输出
 
 #endif //FFMPEGPROJECT_RING_BUFFER_H
\ No newline at end of file
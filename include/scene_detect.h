@@ -0,0 +1,54 @@
+//
+// Created by Jianing on 2026/01/24.
+//
+
+#ifndef FFMPEGPROJECT_SCENE_DETECT_H
+#define FFMPEGPROJECT_SCENE_DETECT_H
+
+#include <vector>
+#include <stdint.h>
+
+extern "C" {
+#include <libavutil/frame.h>
+}
+
+// 场景切换检测参数
+struct SceneCutOptions {
+    bool enabled = false;
+    int max_gop = 250;         // 最长关键帧间隔（帧），静止画面也至少隔这么久插一个关键帧
+    int min_gop = 8;           // 两次场景切换之间的最少帧数（避免闪光等连续触发）
+    double threshold = 12.0;   // 缩小后亮度的平均绝对差（0~255）超过该值才可能是切换
+    double ratio = 2.5;        // 且须超过近期平均差的ratio倍（高运动镜头内不误判）
+};
+
+// 场景切换检测：亮度平面4:1盒式缩小后与上一帧逐像素求SAD（SIMD内核），
+// 在场景切换处和达到最长GOP时要求编码关键帧
+class SceneCutDetector {
+public:
+    explicit SceneCutDetector(const SceneCutOptions& opts);
+
+    // 按顺序送入每一帧（平面YUV，data[0]为亮度），返回该帧是否应编码为关键帧
+    bool next_keyframe(const AVFrame* frame);
+
+    int64_t scene_cuts() const { return cut_count; }
+    int64_t gop_keyframes() const { return gop_count; }
+    // 所有关键帧的帧序号（场景切换处即后续分段并行的天然边界）
+    const std::vector<int64_t>& keyframes() const { return keyframe_list; }
+
+private:
+    // 生成当前帧的缩小亮度图到cur，几何变化时返回false
+    bool build_thumb(const AVFrame* frame);
+
+    SceneCutOptions opts;
+    std::vector<uint8_t> prev, cur;
+    int src_w = 0, src_h = 0;
+    int thumb_w = 0, thumb_h = 0;
+    double avg_score = -1;       // 近期平均差（指数滑动平均），<0表示尚无数据
+    int64_t frame_index = 0;
+    int64_t last_key = 0;
+    int64_t cut_count = 0;
+    int64_t gop_count = 0;
+    std::vector<int64_t> keyframe_list;
+};
+
+#endif //FFMPEGPROJECT_SCENE_DETECT_H
@@ -0,0 +1,33 @@
+//
+// Created by Jianing on 2026/01/18.
+//
+
+#ifndef FFMPEGPROJECT_SIMD_H
+#define FFMPEGPROJECT_SIMD_H
+
+// SIMD内核公共定义：按目标架构引入intrinsics头文件，并为需要运行时分派的
+// 函数提供target属性（GCC/Clang下单个函数可使用比编译选项更高的指令集）
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SIMD_X86 1
+#include <immintrin.h>
+#else
+#define SIMD_X86 0
+#endif
+
+#if defined(__aarch64__) || defined(_M_ARM64) || (defined(__ARM_NEON) && defined(__arm__))
+#define SIMD_NEON 1
+#include <arm_neon.h>
+#else
+#define SIMD_NEON 0
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define SIMD_TARGET_SSE4 __attribute__((target("sse4.1")))
+#define SIMD_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define SIMD_TARGET_SSE4
+#define SIMD_TARGET_AVX2
+#endif
+
+#endif //FFMPEGPROJECT_SIMD_H
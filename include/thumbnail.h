@@ -0,0 +1,24 @@
+//
+// Created by Jianing on 2026/01/08.
+//
+
+#ifndef FFMPEGPROJECT_THUMBNAIL_H
+#define FFMPEGPROJECT_THUMBNAIL_H
+
+#include <string>
+
+// 缩略图/雪碧图任务参数
+struct ThumbnailOptions {
+    int tile_count = 100;                 // 缩略图数量（在时长内均匀分布）
+    int tile_width = 160;                 // 单个缩略图宽度，高度按源宽高比计算
+    int columns = 0;                      // 每行缩略图数，<=0时取ceil(sqrt(tile_count))
+    int threads = 4;                      // 并行缩放线程数
+    std::string sheet_file = "sprite.jpg";   // 雪碧图输出（JPEG）
+    std::string map_file = "sprite.json";    // 时间→缩略图位置映射（JSON）
+};
+
+// 生成雪碧图：按均匀时间点seek到关键帧，只解码关键帧（AVDISCARD_NONKEY），
+// 并行缩放后拼接为一张JPEG，同时输出每个缩略图的时间与坐标
+bool generate_sprite_sheet(const char* input_file, const ThumbnailOptions& opts);
+
+#endif //FFMPEGPROJECT_THUMBNAIL_H
@@ -0,0 +1,72 @@
+//
+// Created by Jianing on 2026/01/22.
+//
+
+#ifndef FFMPEGPROJECT_VIDEO_FILTER_H
+#define FFMPEGPROJECT_VIDEO_FILTER_H
+
+#include <string>
+#include "ring_buffer.h"
+
+extern "C" {
+#include <libavutil/pixfmt.h>
+#include <libavutil/rational.h>
+}
+
+struct AVFilterGraph;
+struct AVFilterContext;
+
+// 滤镜阶段参数
+struct VideoFilterOptions {
+    std::string graph = "null";       // 滤镜描述，如 "yadif=deint=interlaced,crop=1920:800"
+    int threads = 4;                  // 滤镜图切片线程数（AVFilterGraph.nb_threads）
+    AVRational time_base = {1, 25};   // 输入帧pts的时间基
+    AVRational frame_rate = {0, 1};   // 输入帧率（部分滤镜需要，未知时为{0, 1}）
+};
+
+// libavfilter滤镜图封装：buffer → 用户滤镜链 → buffersink
+class VideoFilter {
+public:
+    explicit VideoFilter(const VideoFilterOptions& opts);
+    ~VideoFilter();
+
+    VideoFilter(const VideoFilter&) = delete;
+    VideoFilter& operator=(const VideoFilter&) = delete;
+
+    // 按输入几何建立滤镜图（可在线程启动前调用，以便提前得到输出尺寸）
+    bool configure(int width, int height, AVPixelFormat pix_fmt, AVRational sar);
+    bool is_configured() const { return graph != nullptr; }
+    // 输入几何与当前滤镜图一致
+    bool matches(const AVFrame* frame) const;
+
+    int output_width() const;
+    int output_height() const;
+    AVPixelFormat output_format() const;
+    // 输出帧pts的时间基/输出帧率（fps、setpts等滤镜会改变），未建图时返回输入值
+    AVRational output_time_base() const;
+    AVRational output_frame_rate() const;
+
+    // 送入一帧（保留调用者的引用，nullptr表示输入结束）
+    int send(const AVFrame* frame);
+    // 取出一帧，无输出时返回AVERROR(EAGAIN)，结束后返回AVERROR_EOF
+    int receive(AVFrame* frame);
+
+    // 把本滤镜图的累计信息（耗时、各滤镜输出帧数）写入g_job_stats
+    void report_stats();
+
+private:
+    void free_graph();
+
+    VideoFilterOptions opts;
+    AVFilterGraph* graph = nullptr;
+    AVFilterContext* src_ctx = nullptr;
+    AVFilterContext* sink_ctx = nullptr;
+    int in_w = 0, in_h = 0;
+    int in_fmt = -1;
+};
+
+// 滤镜线程：从in取帧经滤镜图处理后推入out，in结束后冲刷滤镜图并向out发送刷新信号；
+// 输入几何变化时先冲刷旧图再按新几何重建
+void video_filter_thread(VideoFilter* filter, RingBuffer<AVFrame*>* in, RingBuffer<AVFrame*>* out);
+
+#endif //FFMPEGPROJECT_VIDEO_FILTER_H
@@ -0,0 +1,114 @@
+//
+// Created by Jianing on 2026/01/15.
+//
+
+#ifndef FFMPEGPROJECT_VIDEO_SCALER_H
+#define FFMPEGPROJECT_VIDEO_SCALER_H
+
+#include <map>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <tuple>
+#include "ring_buffer.h"
+#include "frame_pool.h"
+#include "broadcast_ring.h"
+
+extern "C" {
+#include <libavutil/pixfmt.h>
+#include <libswscale/swscale.h>
+}
+
+// 缩放/像素格式转换参数
+struct ScaleOptions {
+    int width = 0;                              // 目标宽度，<=0时按高度和源宽高比计算
+    int height = 0;                             // 目标高度，<=0时按宽度和源宽高比计算（都<=0则不缩放）
+    AVPixelFormat pix_fmt = AV_PIX_FMT_YUV420P; // 目标像素格式（编码器输入格式）
+    int sws_flags = SWS_BICUBIC;
+    int threads = 4;                            // 切片并行线程数
+    bool box_fast_path = true;                  // YUV420P恰为2:1/4:1缩小时用SIMD盒式平均代替swscale
+};
+
+// 按选项计算输出尺寸（保持偶数，适配4:2:0）
+void scale_output_size(const ScaleOptions& opts, int src_w, int src_h, int* dst_w, int* dst_h);
+
+// 切片并行线程组：run(n, job)在n个线程上各执行一次job(i)，全部完成后返回
+class SliceWorkers {
+public:
+    explicit SliceWorkers(int threads);
+    ~SliceWorkers();
+
+    SliceWorkers(const SliceWorkers&) = delete;
+    SliceWorkers& operator=(const SliceWorkers&) = delete;
+
+    int size() const { return static_cast<int>(workers.size()) + 1; }
+    void run(int n, const std::function<void(int)>& job);
+
+private:
+    void worker_loop(int index);
+
+    std::vector<std::thread> workers;
+    std::mutex mtx;
+    std::condition_variable start_cv;
+    std::condition_variable done_cv;
+    const std::function<void(int)>* job = nullptr;
+    int job_count = 0;
+    uint64_t generation = 0;
+    int pending = 0;
+    bool quit = false;
+};
+
+// 缩放器：按源几何（宽/高/格式）缓存SwsContext，输出帧按行切成若干带并行缩放；
+// 源与目标几何一致时直接引用源帧，不做任何拷贝；尺寸不变且只需转YUV420P时用SIMD转换内核，
+// YUV420P整2:1/4:1缩小时用SIMD盒式平均
+class VideoScaler {
+public:
+    explicit VideoScaler(const ScaleOptions& opts);
+    ~VideoScaler();
+
+    VideoScaler(const VideoScaler&) = delete;
+    VideoScaler& operator=(const VideoScaler&) = delete;
+
+    // dst需为空帧；成功返回0
+    int scale(const AVFrame* src, AVFrame* dst);
+
+private:
+    // 一个水平带：扩展（含上下滤波余量）后的源/目标行范围，以及输出有效行范围
+    struct Band {
+        SwsContext* sws = nullptr;
+        int src_y = 0, src_h = 0;     // 扩展源行
+        int ext_y = 0, ext_h = 0;     // 扩展目标行
+        int out_y = 0, out_h = 0;     // 写入输出帧的目标行
+        AVFrame* scratch = nullptr;   // 扩展目标缓冲（单带时不需要）
+    };
+
+    struct Geometry {
+        int dst_w = 0, dst_h = 0;
+        bool fast_convert = false;    // 尺寸不变、只做格式转换：走SIMD转换内核
+        int box_factor = 0;           // 非0：按该倍数做盒式平均缩小
+        std::vector<Band> bands;
+    };
+
+    using GeometryKey = std::tuple<int, int, int>;  // 源宽、高、像素格式
+
+    Geometry* get_geometry(const AVFrame* src);
+    bool plan_bands(Geometry* geo, int src_w, int src_h, AVPixelFormat src_fmt);
+    void scale_band(const Band& band, const AVFrame* src, AVFrame* dst) const;
+    static void free_geometry(Geometry* geo);
+
+    ScaleOptions opts;
+    SliceWorkers workers;
+    FramePool pool;
+    std::map<GeometryKey, Geometry*> cache;
+};
+
+// 缩放线程：从in取帧缩放/转换后推入out，in结束后向out发送刷新信号
+void video_scale_thread(ScaleOptions opts, RingBuffer<AVFrame*>* in, RingBuffer<AVFrame*>* out);
+
+// 同上，输入为广播环中的消费者consumer_id
+void video_scale_thread_broadcast(ScaleOptions opts, BroadcastFrameRing* in, int consumer_id,
+                                  RingBuffer<AVFrame*>* out);
+
+#endif //FFMPEGPROJECT_VIDEO_SCALER_H
@@ -6,8 +6,58 @@
 #define FFMPEGPROJECT_VIDEODECODER_H
 
 #include "common.h"
+#include "broadcast_ring.h"
+#include "crop_detect.h"
+#include "live_latency.h"
+#include <vector>
+
+extern "C" {
+#include <libavutil/rational.h>
+}
+
+// 过载（下游跟不上）时的处理方式
+enum class OverloadPolicy {
+    Block,            // 环形缓冲区满时阻塞解码（不丢帧，积压转到Packet队列，延迟无上限）
+    DropNonRef,       // 过载时不解码非参考帧（DISPOSABLE的Packet直接丢、其余按AVDISCARD_NONREF），
+                      // 缓冲区仍满时丢B帧输出，其余帧照常阻塞
+    DropOldest,       // 环形缓冲区满时丢掉其中最旧的一帧，解码从不阻塞，积压最多为缓冲区容量
+    SkipToKeyframe,   // Packet队列积压超过上限或缓冲区满时，丢弃Packet直到下一个关键帧再恢复解码
+};
+
+struct OverloadOptions {
+    OverloadPolicy policy = OverloadPolicy::Block;
+    size_t max_pending_packets = 60;  // Packet队列积压超过该数视为过载（DropNonRef/SkipToKeyframe）
+};
+
+// 视频解码选项
+struct VideoDecodeOptions {
+    AVRational time_base = {0, 1};   // 输入视频流时间基
+    AVRational frame_rate = {0, 1};  // 输入视频流平均帧率
+    // 目标输出帧率（抽帧模式）：{0, 1}表示不抽帧；
+    // 设置后按目标帧率只保留需要的帧，并通过skip_frame/丢包跳过不需要解码的帧
+    AVRational target_fps = {0, 1};
+    // 抽帧用：源的关键帧索引（stream_keyframe_index）。只有索引表明下一个关键帧早于下一个保留时刻时
+    // 才整段跳过GOP剩余部分，否则只跳过非参考帧；为空时从不整段跳过
+    std::vector<int64_t> keyframe_index;
+    // 非空时解码帧推入该广播环（供多个消费者共享），否则推入g_video_frame_ringbuf
+    BroadcastFrameRing* out_broadcast = nullptr;
+    // 非空时对每个输出帧做零拷贝裁剪（黑边检测结果），下游各阶段都按裁剪后的尺寸处理
+    CropRect crop;
+    // >1时，帧内编码的流（codec描述符带AV_CODEC_PROP_INTRA_ONLY，如MJPEG/ProRes）用这么多个
+    // 解码器上下文并行解码，Packet轮流分配、解码结果按Packet顺序重排后输出
+    int intra_workers = 0;
+    // 编码格式本身不是帧内编码、但已知全部为I帧（如全I的MPEG4）时置true，同样走并行路径
+    bool assume_intra_only = false;
+    // 下游跟不上时的丢帧策略（只作用于g_video_frame_ringbuf输出；帧内并行路径只有DropOldest生效）。
+    // 丢帧后保留帧仍带源时间戳，编码按源时间基计时，输出时间轴连续、只是帧间隔变大
+    OverloadOptions overload;
+    // 直播低延迟：解码器不做帧级多线程、按低延迟标志输出（不等待重排）
+    bool low_delay = false;
+    // 非空时给每个输出帧打解码时间戳（连同解封装时间戳挂在frame->opaque_ref上随帧传递）
+    LatencyTracker* latency = nullptr;
+};
 
 // 视频解码线程函数声明
-void video_decode_thread(AVCodecParameters* codec_par);
+void video_decode_thread(AVCodecParameters* codec_par, VideoDecodeOptions opts);
 
 #endif //FFMPEGPROJECT_VIDEODECODER_H
@@ -6,10 +6,33 @@
 #define FFMPEGPROJECT_VIDEOENCODER_H
 #include "ring_buffer.h"
 #include "common.h"
+#include "scene_detect.h"
+#include "quality_meter.h"
+#include "frame_dedup.h"
+#include "encoder_profile.h"
+#include "realtime_effort.h"
+#include "live_latency.h"
 struct AVCodecParameters;
+struct AVCodecContext;
 
-// 视频编码线程（入参：原视频流参数、输出时间基）
-void video_encode_thread(AVCodecParameters* src_codec_par, AVRational output_time_base);
+// 视频编码选项
+struct VideoEncodeOptions {
+    RingBuffer<AVFrame*>* in_ringbuf = &g_video_frame_ringbuf;  // 输入帧来源（解码输出或缩放输出）
+    DeepCopyPacketQueue* out_queue = &g_en_video_pkt_queue;      // 编码输出Packet队列（对应的复用线程从这里取）
+    EncoderProfile profile;                                      // 编码器/码率控制/GOP等，默认即MPEG4 1Mbps GOP 10
+    SceneCutOptions scene_cut;                                   // 启用后关键帧由场景切换检测决定（profile.gop_size不再使用）
+    QualityMeterOptions quality;                                 // 启用后解码自身输出，逐帧/逐GOP计算PSNR/SSIM
+    DedupOptions dedup;                                          // 启用后丢弃与上一保留帧重复的帧（配合src_time_base输出VFR）
+    RealtimeOptions realtime;                                    // 启用后按落后墙钟/输入积压在GOP边界切换编码强度档位
+                                                                 // （profile须不带B帧，换档时重开编码器）
+    LatencyTracker* latency = nullptr;                           // 非空时打送编码/编码输出时间戳（逐帧延迟跟踪）
+    AVRational src_time_base = {0, 1};                           // 输入帧pts的时间基：设置后源时间戳换算到编码器时间基
+                                                                 // 作为帧pts（有B帧时Packet的pts/dts都由此而来），{0, 1}时按帧序号
+};
+
+// 视频编码线程（入参：编码尺寸所依据的视频参数、输出时间基、编码选项）
+void video_encode_thread(AVCodecParameters* src_codec_par, AVRational output_time_base,
+                         VideoEncodeOptions opts);
 
 
 #endif //FFMPEGPROJECT_VIDEOENCODER_H
@@ -0,0 +1,18 @@
+//
+// Created by Jianing on 2026/01/10.
+//
+
+#ifndef FFMPEGPROJECT_Y4M_H
+#define FFMPEGPROJECT_Y4M_H
+
+extern "C" {
+#include <libavutil/pixfmt.h>
+}
+
+// 像素格式 → YUV4MPEG2头中的C（色度采样）标签，Y4M不支持的格式返回nullptr
+const char* y4m_chroma_tag(AVPixelFormat pix_fmt);
+
+// YUV4MPEG2头中的C标签 → 像素格式（无C标签时传nullptr，按420处理），不支持返回AV_PIX_FMT_NONE
+AVPixelFormat y4m_pix_fmt_from_tag(const char* tag);
+
+#endif //FFMPEGPROJECT_Y4M_H
@@ -6,14 +6,157 @@
 #include "videoencoder.h"
 #include "audioencoder.h"
 #include "mux.h"
+#include "thumbnail.h"
+#include "raw_video_source.h"
+#include "video_scaler.h"
+#include "pixfmt_convert.h"
+#include "box_downscale.h"
+#include "abr_ladder.h"
+#include "video_filter.h"
+#include "parallel_encoder.h"
+#include "quality_search.h"
+#include "encode_cost.h"
+#include "job_stats.h"
+#include <chrono>
 
 extern "C" {
 #include <libavformat/avformat.h>
 #include <libavcodec/avcodec.h>
 #include <libavutil/avutil.h>
+#include <libavutil/pixdesc.h>
 }
 #include <windows.h>
 
+// ============ 抽帧输出开关 ============
+// 目标输出帧率（如1、5用于预览/分析），0表示按原帧率全部解码输出
+#define VIDEO_TARGET_FPS 0
+// ====================================
+
+// ============ 雪碧图任务开关 ============
+// 开启后只生成关键帧缩略图雪碧图，不运行转码流水线
+#define ENABLE_THUMBNAIL_JOB 0
+// ====================================
+
+// ============ 滤镜阶段开关 ============
+// 开启后在解码之后插入libavfilter滤镜图（去隔行/裁剪/叠加等），滤镜描述同ffmpeg -vf
+#define ENABLE_VIDEO_FILTER 0
+#define VIDEO_FILTER_GRAPH "yadif=deint=interlaced"
+#define VIDEO_FILTER_THREADS 4
+// ====================================
+
+// ============ 编码配置 ============
+// 内置编码配置名（encoder_profile.cpp）：mpeg4 / mpeg4_fast / mpeg4_hq / mpeg4_q /
+// x264_ultrafast / x264_veryfast / x264_medium，按任务在速度和体积之间取舍
+#define VIDEO_ENCODER_PROFILE "mpeg4"
+// ====================================
+
+// ============ 按内容选码率开关 ============
+// 开启后正式编码前先在全片均匀取几段并行试编码多个码率（或crf/qscale），
+// 取平均SSIM达到目标的最低一档作为本片的码率
+#define ENABLE_QUALITY_SEARCH 0
+#define QUALITY_SEARCH_TARGET_SSIM 0.95
+// ====================================
+
+// ============ 编码开销预测开关 ============
+// 开启后正式编码前预测整片转码的CPU秒数写入encode_cost.json（供调度器装箱），
+// 结束后把实际CPU秒数追加到历史文件用于校准和误差统计；ONLY为1时只预测不编码
+#define ENABLE_COST_PREDICT 0
+#define COST_PREDICT_ONLY 0
+// ====================================
+
+// ============ 场景切换关键帧开关 ============
+// 开启后在场景切换处强制关键帧，静止画面按最长GOP插关键帧（替代固定gop_size=10）
+#define ENABLE_SCENE_CUT 0
+#define SCENE_CUT_MAX_GOP 250
+// ====================================
+
+// ============ 编码质量评估开关 ============
+// 开启后编码线程解码自身输出，与源帧比较得到PSNR/SSIM，写入quality_frames.csv / quality_gops.csv
+#define ENABLE_QUALITY_METER 0
+#define QUALITY_SAMPLE_INTERVAL 1   // 每N帧评估一帧
+// ====================================
+
+// ============ 重复帧消除开关 ============
+// 开启后编码前丢弃与上一保留帧相同（录屏/幻灯片的静止段）的帧，保留帧按源时间戳计时输出VFR
+#define ENABLE_FRAME_DEDUP 0
+#define DEDUP_THRESHOLD 0.0         // 每字节平均绝对差阈值，0只丢完全相同的帧
+// ====================================
+
+// ============ 实时模式开关 ============
+// 开启后编码须跟上墙钟：按帧相对源时间的落后和输入缓冲区积压，在GOP边界逐档降低运动估计/宏块决策开销，
+// 负载下降后再逐档恢复（不用B帧；线程数不变，会写进mpeg4的VOL头；并行GOP编码时不生效）
+#define ENABLE_REALTIME_MODE 0
+#define REALTIME_LATE_HIGH 0.5      // 落后墙钟超过该秒数时降档
+// 下游跟不上时解码端的丢帧策略（videodecoder.h）：Block / DropNonRef / DropOldest / SkipToKeyframe，
+// Block以外的策略让端到端延迟有上限，丢帧数计入任务统计
+#define VIDEO_OVERLOAD_POLICY OverloadPolicy::Block
+#define OVERLOAD_MAX_PENDING_PACKETS 60
+// ====================================
+
+// ============ 直播低延迟开关 ============
+// 开启后按直播监看调优：帧缓冲区改为极小深度并自旋交接、缓冲区满时丢最旧帧（过载策略为Block时）、
+// 解码/编码都不做重排（无B帧、无lookahead）、复用写分片MP4且逐Packet刷盘，
+// 统计每帧采集→写盘延迟并与目标比较（不支持并行GOP编码）
+#define ENABLE_LIVE_MODE 0
+#define LIVE_LATENCY_TARGET_MS 100
+#define LIVE_QUEUE_DEPTH 1          // 各帧缓冲区容量
+#define LIVE_SPIN_US 500            // 交接时阻塞前的自旋时长（微秒）
+#define LIVE_PACE_INPUT 1           // 文件输入按实时速度读取（真实直播源设0）
+// ====================================
+
+// ============ 逐帧延迟跟踪开关 ============
+// 开启后每帧在解封装、解码输出、送编码、编码输出、复用写出打时间戳，按阶段统计p50/p99/max，
+// 运行中每LATENCY_REPORT_INTERVAL帧输出一次，结束时汇总（直播模式下总是开启）
+#define ENABLE_LATENCY_TRACE 0
+#define LATENCY_REPORT_INTERVAL 250
+// ====================================
+
+// ============ 并行GOP编码开关 ============
+// 开启后把帧切成封闭GOP，由多个编码器实例并行编码，经重排缓冲按序输出（单路流的编码扩展）
+#define ENABLE_PARALLEL_ENCODE 0
+#define PARALLEL_ENCODE_WORKERS 4
+// ====================================
+
+// ============ 帧内编码并行解码开关 ============
+// 开启后帧内编码的输入（MJPEG/ProRes/DNxHD等）由多个解码器上下文并行解码，按Packet顺序输出；
+// 其他格式不受影响，仍走单解码器
+#define ENABLE_INTRA_PARALLEL_DECODE 0
+#define INTRA_DECODE_WORKERS 4
+// ====================================
+
+// ============ 黑边裁剪开关 ============
+// 开启后先对片头取样检测稳定的黑边，解码输出即按检测结果零拷贝裁剪，编码尺寸随之缩小
+#define ENABLE_CROP_DETECT 0
+// ====================================
+
+// ============ 缩放阶段开关 ============
+// 开启后在解码与编码之间插入切片并行的缩放/格式转换线程（如4K→1080p/720p）
+#define ENABLE_VIDEO_SCALE 0
+#define VIDEO_SCALE_WIDTH 1280
+#define VIDEO_SCALE_HEIGHT 0    // 0：按源宽高比计算
+#define VIDEO_SCALE_THREADS 4
+// ====================================
+
+// ============ 码率阶梯任务开关 ============
+// 开启后只解码一次，同时输出1080p/720p/480p/360p多档（高于源分辨率的档位跳过）
+#define ENABLE_ABR_LADDER 0
+// ====================================
+
+// ============ 编码器基准开关 ============
+// 开启后从mmap的原始.yuv/.y4m直接供帧给编码线程（无解封装/解码/拷贝）
+#define ENABLE_RAW_ENCODE_BENCH 0
+#define RAW_BENCH_INPUT "../input.y4m"
+#define RAW_BENCH_LOOPS 1
+// ====================================
+
+// ============ 像素格式转换基准开关 ============
+// 开启后校验SIMD转换/盒式缩小内核与C实现逐字节一致，并与swscale比较吞吐（GB/s）
+#define ENABLE_PIXFMT_BENCH 0
+#define PIXFMT_BENCH_WIDTH 1920
+#define PIXFMT_BENCH_HEIGHT 1080
+#define PIXFMT_BENCH_ITERATIONS 200
+// ====================================
+
 void verify_output_file(const std::string& filename) {
     AVFormatContext* fmt_ctx = nullptr;
 
@@ -44,6 +187,54 @@ void verify_output_file(const std::string& filename) {
     avformat_close_input(&fmt_ctx);
 }
 
+// 编码器基准：原始视频源 → 编码 → 复用，输出编码吞吐
+int run_raw_encode_benchmark(const char* input_file, const char* output_file) {
+    RawVideoSourceOptions raw_opts;
+    raw_opts.filename = input_file;
+    RawVideoSource source;
+    if (!source.open(raw_opts)) {
+        return -1;
+    }
+
+    AVCodecParameters* raw_par = avcodec_parameters_alloc();
+    source.fill_codec_par(raw_par);
+    if (raw_par->format != AV_PIX_FMT_YUV420P &&
+        !can_convert_to_yuv420p(static_cast<AVPixelFormat>(raw_par->format))) {
+        std::cerr << "[Bench Warn] 编码器只接受YUV420P输入（及可快速转换的格式），当前为"
+                  << av_get_pix_fmt_name(static_cast<AVPixelFormat>(raw_par->format)) << "\n";
+    }
+    AVRational enc_time_base = av_inv_q(source.get_frame_rate());
+    VideoEncodeOptions enc_opts;
+    AVCodecParameters* mux_par = nullptr;
+    if (find_encoder_profile(VIDEO_ENCODER_PROFILE, &enc_opts.profile)) {
+        enc_opts.profile.color_range = yuv420p_color_range(static_cast<AVPixelFormat>(raw_par->format),
+                                                           raw_par->color_range);
+        mux_par = make_encoder_params(enc_opts.profile, raw_par->width, raw_par->height, enc_time_base);
+    }
+    if (!mux_par) {
+        avcodec_parameters_free(&raw_par);
+        return -1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::thread source_th(raw_video_source_thread, &source, RAW_BENCH_LOOPS);
+    std::thread video_enc_th(video_encode_thread, raw_par, enc_time_base, enc_opts);
+    std::thread mux_th(mux_thread, std::string(output_file), mux_par, nullptr, enc_time_base,
+                       &g_en_video_pkt_queue, MuxOptions());
+    source_th.join();
+    video_enc_th.join();
+    mux_th.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    int64_t frames = static_cast<int64_t>(source.frame_count()) * RAW_BENCH_LOOPS;
+    std::cout << "[Bench] 编码 " << frames << " 帧，耗时 " << seconds << " 秒，吞吐 "
+              << (seconds > 0 ? frames / seconds : 0.0) << " fps\n";
+
+    avcodec_parameters_free(&raw_par);
+    avcodec_parameters_free(&mux_par);
+    return 0;
+}
+
 int main(int argc, char* argv[])
 {
     SetConsoleOutputCP(CP_UTF8);  // 设置控制台输出为 UTF-8
@@ -54,6 +245,43 @@ int main(int argc, char* argv[])
     // 初始化FFmpeg
     avformat_network_init();
 
+#if ENABLE_THUMBNAIL_JOB
+    ThumbnailOptions thumb_opts;
+    thumb_opts.sheet_file = "../sprite.jpg";
+    thumb_opts.map_file = "../sprite.json";
+    bool thumb_ok = generate_sprite_sheet(input_file, thumb_opts);
+    avformat_network_deinit();
+    return thumb_ok ? 0 : -1;
+#endif
+
+#if ENABLE_ABR_LADDER
+    LadderOptions ladder_opts;
+    ladder_opts.renditions = {
+            {"../output_1080p.mp4", 1080, 5000000, 50},
+            {"../output_720p.mp4", 720, 2500000, 50},
+            {"../output_480p.mp4", 480, 1000000, 50},
+            {"../output_360p.mp4", 360, 600000, 50},
+    };
+    ladder_opts.encoder_profile = VIDEO_ENCODER_PROFILE;
+    bool ladder_ok = run_abr_ladder(input_file, ladder_opts);
+    avformat_network_deinit();
+    return ladder_ok ? 0 : -1;
+#endif
+
+#if ENABLE_PIXFMT_BENCH
+    bool kernels_ok = pixfmt_kernels_self_check();
+    pixfmt_benchmark(PIXFMT_BENCH_WIDTH, PIXFMT_BENCH_HEIGHT, PIXFMT_BENCH_ITERATIONS);
+    box_downscale_benchmark(PIXFMT_BENCH_WIDTH, PIXFMT_BENCH_HEIGHT, PIXFMT_BENCH_ITERATIONS);
+    avformat_network_deinit();
+    return kernels_ok ? 0 : -1;
+#endif
+
+#if ENABLE_RAW_ENCODE_BENCH
+    int bench_ret = run_raw_encode_benchmark(RAW_BENCH_INPUT, output_file);
+    avformat_network_deinit();
+    return bench_ret;
+#endif
+
     // 打开输入文件 & 获取流信息
     AVFormatContext* fmt_ctx = nullptr;
     if (avformat_open_input(&fmt_ctx, input_file, nullptr, nullptr) < 0) {
@@ -87,48 +315,226 @@ int main(int argc, char* argv[])
     AVCodecParameters* audio_dec_par = fmt_ctx->streams[audio_stream_idx]->codecpar;
 
 
-    AVCodecParameters* mpeg4_params = avcodec_parameters_alloc();
-    mpeg4_params->codec_type = AVMEDIA_TYPE_VIDEO;
-    mpeg4_params->codec_id = AV_CODEC_ID_MPEG4;  // MPEG4的ID是12
-    mpeg4_params->codec_tag = 0x7634706d;  // 'mp4v'的小端表示
-    mpeg4_params->width = video_dec_par->width;
-    mpeg4_params->height = video_dec_par->height;
-    mpeg4_params->format = AV_PIX_FMT_YUV420P;
-    mpeg4_params->bit_rate = 1000000;
-
-    std::cout << "[Main] 创建MPEG4编码参数: codec_id=" << mpeg4_params->codec_id
-              << ", codec_tag=0x" << std::hex << mpeg4_params->codec_tag << std::dec
-              << ", 分辨率=" << mpeg4_params->width << "x" << mpeg4_params->height << "\n";
+    // 编码尺寸：依次经过黑边裁剪（可选）、滤镜（可选）、缩放（可选）后的尺寸，都未启用时与源一致
+    AVCodecParameters* video_enc_src_par = avcodec_parameters_alloc();
+    avcodec_parameters_copy(video_enc_src_par, video_dec_par);
+    CropRect video_crop;
+#if ENABLE_CROP_DETECT
+    if (detect_black_borders(input_file, CropDetectOptions(), &video_crop)) {
+        video_enc_src_par->width -= video_crop.left + video_crop.right;
+        video_enc_src_par->height -= video_crop.top + video_crop.bottom;
+    }
+#endif
+#if ENABLE_VIDEO_FILTER
+    VideoFilterOptions filter_opts;
+    filter_opts.graph = VIDEO_FILTER_GRAPH;
+    filter_opts.threads = VIDEO_FILTER_THREADS;
+    filter_opts.time_base = fmt_ctx->streams[video_stream_idx]->time_base;
+    filter_opts.frame_rate = fmt_ctx->streams[video_stream_idx]->avg_frame_rate;
+    VideoFilter video_filter(filter_opts);
+    // 按解码参数提前建图以得到滤镜输出尺寸（如crop之后）；失败时由滤镜线程按首帧建图
+    if (video_filter.configure(video_enc_src_par->width, video_enc_src_par->height,
+                               static_cast<AVPixelFormat>(video_dec_par->format), video_dec_par->sample_aspect_ratio)) {
+        video_enc_src_par->width = video_filter.output_width();
+        video_enc_src_par->height = video_filter.output_height();
+    }
+#endif
+#if ENABLE_VIDEO_SCALE
+    ScaleOptions scale_opts;
+    scale_opts.width = VIDEO_SCALE_WIDTH;
+    scale_opts.height = VIDEO_SCALE_HEIGHT;
+    scale_opts.threads = VIDEO_SCALE_THREADS;
+    scale_output_size(scale_opts, video_enc_src_par->width, video_enc_src_par->height,
+                      &video_enc_src_par->width, &video_enc_src_par->height);
+#endif
+    // 编码器输入帧的时间戳：解码输出（滤镜可能改变时间基/帧率）
+    AVRational video_src_time_base = fmt_ctx->streams[video_stream_idx]->time_base;
+    AVRational video_src_frame_rate = fmt_ctx->streams[video_stream_idx]->avg_frame_rate;
+#if ENABLE_VIDEO_FILTER
+    if (video_filter.is_configured()) {
+        video_src_time_base = video_filter.output_time_base();
+        video_src_frame_rate = video_filter.output_frame_rate();
+    }
+#endif
+    // 编码时间基：抽帧模式下按目标帧率，否则按源帧率，源时间戳换算后落在整数刻度上；
+    // Packet的pts/dts都以它为单位，复用线程再换算到容器的流时间基
+    AVRational video_enc_time_base = {1, 25};
+    if (VIDEO_TARGET_FPS > 0) {
+        video_enc_time_base = (AVRational){1, VIDEO_TARGET_FPS};
+    } else if (video_src_frame_rate.num > 0 && video_src_frame_rate.den > 0) {
+        video_enc_time_base = av_inv_q(video_src_frame_rate);
+    }
+    // 复用参数由编码配置打开的编码器导出，与编码线程中的编码器一致
+    EncoderProfile video_profile;
+    AVCodecParameters* video_mux_par = nullptr;
+    if (find_encoder_profile(VIDEO_ENCODER_PROFILE, &video_profile)) {
+#if ENABLE_QUALITY_SEARCH
+        QualitySearchOptions search_opts;
+        search_opts.target_ssim = QUALITY_SEARCH_TARGET_SSIM;
+        search_opts.crop = video_crop;
+        search_encode_quality(input_file, video_enc_src_par->width, video_enc_src_par->height, video_enc_time_base,
+                              search_opts, &video_profile);  // 失败时按配置原有码率编码
+#endif
+#if ENABLE_REALTIME_MODE
+        video_profile.max_b_frames = 0;  // 与编码线程一致，复用参数按无B帧导出
+#endif
+#if ENABLE_LIVE_MODE
+        apply_low_latency(&video_profile);
+#endif
+        // 全范围源（YUVJ）转换后仍是全范围，编码器和复用参数须一致标记
+        video_profile.color_range = yuv420p_color_range(static_cast<AVPixelFormat>(video_enc_src_par->format),
+                                                        video_enc_src_par->color_range);
+        video_mux_par = make_encoder_params(video_profile, video_enc_src_par->width, video_enc_src_par->height,
+                                            video_enc_time_base);
+    }
+    if (!video_mux_par) {
+        avcodec_parameters_free(&video_enc_src_par);
+        avformat_close_input(&fmt_ctx);
+        return -1;
+    }
+#if ENABLE_COST_PREDICT
+    CostPredictOptions cost_opts;
+    cost_opts.crop = video_crop;
+    CostEstimate cost_estimate;
+    bool cost_predicted = predict_encode_cost(input_file, video_profile, video_enc_src_par->width,
+                                              video_enc_src_par->height, video_enc_time_base, cost_opts,
+                                              &cost_estimate);
+#if COST_PREDICT_ONLY
+    avcodec_parameters_free(&video_mux_par);
+    avcodec_parameters_free(&video_enc_src_par);
+    avformat_close_input(&fmt_ctx);
+    avformat_network_deinit();
+    return cost_predicted ? 0 : -1;
+#endif
+    double job_cpu_start = process_cpu_seconds();
+#endif
     // 定义输出时间基（统一为输入视频流的时间基，保证同步）
     AVRational output_time_base = fmt_ctx->streams[video_stream_idx]->time_base;
 
+    DemuxOptions demux_opts;
+    MuxOptions mux_opts;
+#if ENABLE_LIVE_MODE || ENABLE_LATENCY_TRACE
+    LatencyTracker latency_tracker(ENABLE_LIVE_MODE ? LIVE_LATENCY_TARGET_MS / 1000.0 : 0.0, LATENCY_REPORT_INTERVAL);
+    demux_opts.latency = &latency_tracker;
+    mux_opts.latency = &latency_tracker;
+#endif
+#if ENABLE_LIVE_MODE
+    // 直播：小队列 + 自旋交接
+    for (RingBuffer<AVFrame*>* ringbuf : {&g_video_frame_ringbuf, &g_video_filtered_frame_ringbuf,
+                                          &g_video_scaled_frame_ringbuf}) {
+        ringbuf->resize(LIVE_QUEUE_DEPTH);
+        ringbuf->set_spin_wait(LIVE_SPIN_US);
+    }
+    demux_opts.pace = LIVE_PACE_INPUT;
+    mux_opts.low_latency = true;
+#endif
+
+    // 关键帧索引在读包过程中还会被解封装器追加，须在解封装线程启动前取
+    std::vector<int64_t> video_keyframe_index;
+    if (VIDEO_TARGET_FPS > 0) {
+        video_keyframe_index = stream_keyframe_index(fmt_ctx->streams[video_stream_idx]);
+    }
+
     // ====================== 创建所有线程 ======================
     // 1. 解封装线程
-    std::thread demux_th(demux_thread, fmt_ctx, video_stream_idx, audio_stream_idx);
+    std::thread demux_th(demux_thread, fmt_ctx, video_stream_idx, audio_stream_idx, demux_opts);
 
     // 2. 解码线程
-    std::thread video_dec_th(video_decode_thread, video_dec_par);
+    VideoDecodeOptions video_dec_opts;
+    video_dec_opts.time_base = fmt_ctx->streams[video_stream_idx]->time_base;
+    video_dec_opts.frame_rate = fmt_ctx->streams[video_stream_idx]->avg_frame_rate;
+    video_dec_opts.target_fps = (AVRational){VIDEO_TARGET_FPS, 1};
+    video_dec_opts.keyframe_index = std::move(video_keyframe_index);
+    video_dec_opts.crop = video_crop;
+    video_dec_opts.overload.policy = VIDEO_OVERLOAD_POLICY;
+    video_dec_opts.overload.max_pending_packets = OVERLOAD_MAX_PENDING_PACKETS;
+#if ENABLE_LIVE_MODE
+    video_dec_opts.low_delay = true;
+    if (video_dec_opts.overload.policy == OverloadPolicy::Block) {
+        video_dec_opts.overload.policy = OverloadPolicy::DropOldest;  // 解码从不阻塞，积压最多一个缓冲区
+    }
+#endif
+#if ENABLE_INTRA_PARALLEL_DECODE
+    video_dec_opts.intra_workers = INTRA_DECODE_WORKERS;
+#endif
+#if ENABLE_LIVE_MODE || ENABLE_LATENCY_TRACE
+    video_dec_opts.latency = &latency_tracker;
+#endif
+    std::thread video_dec_th(video_decode_thread, video_dec_par, video_dec_opts);
     // std::thread audio_dec_th(audio_decode_thread, audio_dec_par);
 
-    // 3. 编码线程
-    std::thread video_enc_th(video_encode_thread, video_dec_par, (AVRational){1, 25});
+    // 3. 滤镜线程（可选）+ 缩放线程（可选）+ 编码线程
+    RingBuffer<AVFrame*>* video_frames = &g_video_frame_ringbuf;  // 编码器之前最后一个阶段的输出
+#if ENABLE_VIDEO_FILTER
+    std::thread video_filter_th(video_filter_thread, &video_filter, video_frames, &g_video_filtered_frame_ringbuf);
+    video_frames = &g_video_filtered_frame_ringbuf;
+#endif
+#if ENABLE_VIDEO_SCALE
+    std::thread video_scale_th(video_scale_thread, scale_opts, video_frames, &g_video_scaled_frame_ringbuf);
+    video_frames = &g_video_scaled_frame_ringbuf;
+#endif
+    VideoEncodeOptions video_enc_opts;
+    video_enc_opts.in_ringbuf = video_frames;
+    video_enc_opts.profile = video_profile;
+    video_enc_opts.scene_cut.enabled = ENABLE_SCENE_CUT;
+    video_enc_opts.scene_cut.max_gop = SCENE_CUT_MAX_GOP;
+    video_enc_opts.quality.enabled = ENABLE_QUALITY_METER;
+    video_enc_opts.quality.sample_interval = QUALITY_SAMPLE_INTERVAL;
+    // 源时间戳带入编码器（有B帧时pts/dts才能正确重排；丢重复帧后为VFR）
+    video_enc_opts.src_time_base = video_src_time_base;
+#if ENABLE_FRAME_DEDUP
+    video_enc_opts.dedup.enabled = true;
+    video_enc_opts.dedup.threshold = DEDUP_THRESHOLD;
+#endif
+#if ENABLE_REALTIME_MODE
+    video_enc_opts.realtime.enabled = true;
+    video_enc_opts.realtime.late_high = REALTIME_LATE_HIGH;
+#endif
+#if ENABLE_LIVE_MODE || ENABLE_LATENCY_TRACE
+    video_enc_opts.latency = &latency_tracker;
+#endif
+#if ENABLE_PARALLEL_ENCODE
+    ParallelEncodeOptions parallel_enc_opts;
+    parallel_enc_opts.encode = video_enc_opts;
+    parallel_enc_opts.workers = PARALLEL_ENCODE_WORKERS;
+    std::thread video_enc_th(parallel_encode_thread, video_enc_src_par, video_enc_time_base, parallel_enc_opts);
+#else
+    std::thread video_enc_th(video_encode_thread, video_enc_src_par, video_enc_time_base, video_enc_opts);
+#endif
     // std::thread audio_enc_th(audio_encode_thread, audio_dec_par, output_time_base);
 
-    // 4. 复用线程 - 直接构造MPEG4编码参数
-
-
-    std::thread mux_th(mux_thread, std::string(output_file), mpeg4_params, audio_dec_par);
+    // 4. 复用线程
+    std::thread mux_th(mux_thread, std::string(output_file), video_mux_par, audio_dec_par, video_enc_time_base,
+                       &g_en_video_pkt_queue, mux_opts);
 
     // ====================== 等待线程结束 ======================
     demux_th.join();
     video_dec_th.join();
     // audio_dec_th.join();
+#if ENABLE_VIDEO_FILTER
+    video_filter_th.join();
+#endif
+#if ENABLE_VIDEO_SCALE
+    video_scale_th.join();
+#endif
     video_enc_th.join();
     // audio_enc_th.join();
     mux_th.join();
 
+    g_job_stats.print();
+#if ENABLE_LIVE_MODE || ENABLE_LATENCY_TRACE
+    latency_tracker.print();
+#endif
+#if ENABLE_COST_PREDICT
+    if (cost_predicted) {
+        record_encode_cost(cost_opts, cost_estimate, process_cpu_seconds() - job_cpu_start);
+    }
+#endif
+
     // 释放资源
     verify_output_file(std::string(output_file));
+    avcodec_parameters_free(&video_mux_par);
+    avcodec_parameters_free(&video_enc_src_par);
     avformat_close_input(&fmt_ctx);
     avformat_network_deinit();
 
@@ -0,0 +1,172 @@
+//
+// Created by Jianing on 2026/01/20.
+//
+#include "abr_ladder.h"
+#include "demux.h"
+#include "videodecoder.h"
+#include "videoencoder.h"
+#include "video_scaler.h"
+#include "mux.h"
+#include "pixfmt_convert.h"
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+}
+
+namespace {
+
+// 一档输出的全部状态：广播环消费者 → 缩放 → 编码 → 复用
+struct LadderBranch {
+    explicit LadderBranch(uint32_t capacity) : scaled(capacity) {}
+
+    LadderRendition rendition;
+    EncoderProfile profile;
+    int consumer_id = -1;
+    RingBuffer<AVFrame*> scaled;
+    DeepCopyPacketQueue packets;
+    AVCodecParameters* enc_src_par = nullptr;
+    AVCodecParameters* mux_par = nullptr;
+    std::thread scale_th;
+    std::thread enc_th;
+    std::thread mux_th;
+
+    ~LadderBranch() {
+        avcodec_parameters_free(&enc_src_par);
+        avcodec_parameters_free(&mux_par);
+    }
+};
+
+} // namespace
+
+bool run_abr_ladder(const char* input_file, const LadderOptions& opts) {
+    AVFormatContext* fmt_ctx = nullptr;
+    if (avformat_open_input(&fmt_ctx, input_file, nullptr, nullptr) < 0) {
+        std::cerr << "[Ladder Error] 打开输入文件失败: " << input_file << "\n";
+        return false;
+    }
+    if (avformat_find_stream_info(fmt_ctx, nullptr) < 0) {
+        std::cerr << "[Ladder Error] 获取媒体流信息失败\n";
+        avformat_close_input(&fmt_ctx);
+        return false;
+    }
+    int video_stream_idx = av_find_best_stream(fmt_ctx, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+    if (video_stream_idx < 0) {
+        std::cerr << "[Ladder Error] 未找到视频流\n";
+        avformat_close_input(&fmt_ctx);
+        return false;
+    }
+    AVStream* video_stream = fmt_ctx->streams[video_stream_idx];
+    AVCodecParameters* video_dec_par = video_stream->codecpar;
+
+    AVRational frame_rate = av_guess_frame_rate(fmt_ctx, video_stream, nullptr);
+    AVRational enc_time_base = frame_rate.num > 0 && frame_rate.den > 0 ? av_inv_q(frame_rate)
+                                                                        : (AVRational){1, 25};
+
+    EncoderProfile base_profile;
+    if (!find_encoder_profile(opts.encoder_profile, &base_profile)) {
+        avformat_close_input(&fmt_ctx);
+        return false;
+    }
+
+    // 为每档准备缩放尺寸与编码/复用参数
+    std::vector<std::unique_ptr<LadderBranch>> branches;
+    for (const auto& rendition : opts.renditions) {
+        if (!opts.allow_upscale && rendition.height > video_dec_par->height) {
+            std::cout << "[Ladder Info] 跳过 " << rendition.height << "p（高于源分辨率 "
+                      << video_dec_par->height << "p）: " << rendition.output_file << "\n";
+            continue;
+        }
+        auto branch = std::make_unique<LadderBranch>(static_cast<uint32_t>(std::max(opts.branch_capacity, 1)));
+        branch->rendition = rendition;
+
+        ScaleOptions scale_opts;
+        scale_opts.height = rendition.height;
+        branch->enc_src_par = avcodec_parameters_alloc();
+        avcodec_parameters_copy(branch->enc_src_par, video_dec_par);
+        scale_output_size(scale_opts, video_dec_par->width, video_dec_par->height,
+                          &branch->enc_src_par->width, &branch->enc_src_par->height);
+        branch->profile = base_profile;
+        branch->profile.bit_rate = rendition.bit_rate;
+        branch->profile.gop_size = rendition.gop_size;
+        branch->profile.color_range = yuv420p_color_range(static_cast<AVPixelFormat>(video_dec_par->format),
+                                                          video_dec_par->color_range);
+        branch->mux_par = make_encoder_params(branch->profile, branch->enc_src_par->width,
+                                              branch->enc_src_par->height, enc_time_base);
+        if (!branch->mux_par) {
+            std::cerr << "[Ladder Warn] 跳过 " << rendition.height << "p：编码器打开失败\n";
+            continue;
+        }
+        branches.push_back(std::move(branch));
+    }
+    if (branches.empty()) {
+        std::cerr << "[Ladder Error] 没有可输出的档位\n";
+        avformat_close_input(&fmt_ctx);
+        return false;
+    }
+
+    // 【一次性信息】阶梯概况
+    std::cout << "[Ladder Info] 源 " << video_dec_par->width << "x" << video_dec_par->height
+              << "，解码一次输出 " << branches.size() << " 档:";
+    for (const auto& branch : branches) {
+        std::cout << " " << branch->enc_src_par->width << "x" << branch->enc_src_par->height
+                  << "@" << branch->rendition.bit_rate / 1000 << "k";
+    }
+    std::cout << "\n";
+
+    auto start = std::chrono::steady_clock::now();
+
+    // 解码帧经广播环共享给各档（只增加引用计数，不拷贝像素）；各档都是普通消费者，
+    // 最慢一档落后一整圈时解码阻塞，整条阶梯按最慢一档的速度推进
+    BroadcastFrameRing frames(static_cast<uint32_t>(std::max(opts.branch_capacity, 1)));
+    for (auto& branch : branches) {
+        branch->consumer_id = frames.add_consumer(branch->rendition.output_file);
+    }
+
+    // 各档下游线程先启动，解码线程再开始推帧
+    for (auto& branch : branches) {
+        ScaleOptions scale_opts;
+        scale_opts.height = branch->rendition.height;
+        scale_opts.threads = opts.scale_threads;
+        branch->scale_th = std::thread(video_scale_thread_broadcast, scale_opts, &frames, branch->consumer_id,
+                                       &branch->scaled);
+
+        VideoEncodeOptions enc_opts;
+        enc_opts.in_ringbuf = &branch->scaled;
+        enc_opts.out_queue = &branch->packets;
+        enc_opts.profile = branch->profile;
+        enc_opts.src_time_base = video_stream->time_base;
+        branch->enc_th = std::thread(video_encode_thread, branch->enc_src_par, enc_time_base, enc_opts);
+
+        branch->mux_th = std::thread(mux_thread, branch->rendition.output_file, branch->mux_par, nullptr,
+                                     enc_time_base, &branch->packets, MuxOptions());
+    }
+
+    VideoDecodeOptions dec_opts;
+    dec_opts.time_base = video_stream->time_base;
+    dec_opts.frame_rate = video_stream->avg_frame_rate;
+    dec_opts.out_broadcast = &frames;
+    std::thread demux_th(demux_thread, fmt_ctx, video_stream_idx, -1, DemuxOptions());
+    std::thread video_dec_th(video_decode_thread, video_dec_par, dec_opts);
+
+    demux_th.join();
+    video_dec_th.join();
+    for (auto& branch : branches) {
+        branch->scale_th.join();
+        branch->enc_th.join();
+        branch->mux_th.join();
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    frames.print_stats();
+    std::cout << "[Ladder Info] 码率阶梯完成：" << branches.size() << " 档，耗时 " << seconds << " 秒\n";
+
+    branches.clear();
+    avformat_close_input(&fmt_ctx);
+    return true;
+}
@@ -0,0 +1,133 @@
+//
+// Created by Jianing on 2026/01/23.
+//
+#include "box_downscale.h"
+#include "pixfmt_kernels.h"
+#include "video_scaler.h"
+#include <iostream>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <algorithm>
+
+extern "C" {
+#include <libavutil/imgutils.h>
+#include <libswscale/swscale.h>
+}
+
+namespace {
+
+// 处理输出亮度行[y0, y1)及对应的色度行（y0/y1为偶数，色度行恰好对齐）
+void box_rows(const PixFmtKernels& k, const AVFrame* src, AVFrame* dst, int factor, int y0, int y1) {
+    for (int p = 0; p < 3; p++) {
+        int shift = p ? 1 : 0;
+        int dst_w = dst->width >> shift;
+        int row_begin = y0 >> shift;
+        int row_end = y1 >> shift;
+        const int ls = src->linesize[p];
+
+        // 每个输出行只顺序读取factor行源数据，源数据各读一次，行带内连续访问
+        for (int y = row_begin; y < row_end; y++) {
+            const uint8_t* r = src->data[p] + static_cast<ptrdiff_t>(y) * factor * ls;
+            uint8_t* out = dst->data[p] + static_cast<ptrdiff_t>(y) * dst->linesize[p];
+            if (factor == 2) {
+                k.box2_row(r, r + ls, out, dst_w);
+            } else {
+                k.box4_row(r, r + ls, r + 2 * ls, r + 3 * ls, out, dst_w);
+            }
+        }
+    }
+}
+
+void box_frame(const PixFmtKernels& k, const AVFrame* src, AVFrame* dst, int factor, SliceWorkers* workers) {
+    int n = workers ? workers->size() : 1;
+    // 行带按2行对齐，保证色度行不跨带
+    int pairs = dst->height / 2;
+    n = std::max(1, std::min(n, pairs));
+    auto band = [&](int i) {
+        box_rows(k, src, dst, factor, 2 * (pairs * i / n), 2 * (pairs * (i + 1) / n));
+    };
+    if (n > 1) {
+        workers->run(n, band);
+    } else {
+        band(0);
+    }
+}
+
+} // namespace
+
+int box_downscale_factor(int src_w, int src_h, int dst_w, int dst_h) {
+    if (dst_w <= 0 || dst_h <= 0 || (dst_w & 1) || (dst_h & 1)) {
+        return 0;
+    }
+    for (int factor : {2, 4}) {
+        if (src_w == dst_w * factor && src_h == dst_h * factor) {
+            return factor;
+        }
+    }
+    return 0;
+}
+
+void box_downscale_yuv420p(const AVFrame* src, AVFrame* dst, int factor, SliceWorkers* workers) {
+    box_frame(pixfmt_kernels(), src, dst, factor, workers);
+}
+
+void box_downscale_benchmark(int width, int height, int iterations) {
+    std::vector<const PixFmtKernels*> kernels = pixfmt_kernels_available();
+    AVFrame* src = av_frame_alloc();
+    AVFrame* dst = av_frame_alloc();
+    src->format = AV_PIX_FMT_YUV420P;
+    src->width = width & ~7;
+    src->height = height & ~7;
+    if (av_frame_get_buffer(src, 0) < 0) {
+        av_frame_free(&src);
+        av_frame_free(&dst);
+        return;
+    }
+    std::mt19937 rng(2);
+    for (int p = 0; p < 3; p++) {
+        int h = p ? src->height / 2 : src->height;
+        for (int i = 0; i < src->linesize[p] * h; i++) {
+            src->data[p][i] = static_cast<uint8_t>(rng());
+        }
+    }
+    double frame_bytes = av_image_get_buffer_size(AV_PIX_FMT_YUV420P, src->width, src->height, 1);
+
+    for (int factor : {2, 4}) {
+        av_frame_unref(dst);
+        dst->format = AV_PIX_FMT_YUV420P;
+        dst->width = src->width / factor;
+        dst->height = src->height / factor;
+        if (av_frame_get_buffer(dst, 0) < 0) {
+            break;
+        }
+
+        auto report = [&](const std::string& name, double seconds) {
+            std::cout << "[BoxScale Bench] " << factor << ":1 " << name << ": "
+                      << (seconds > 0 ? frame_bytes * iterations / seconds / 1e9 : 0.0) << " GB/s\n";
+        };
+
+        // 单线程比较内核本身
+        for (const PixFmtKernels* k : kernels) {
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < iterations; i++) {
+                box_frame(*k, src, dst, factor, nullptr);
+            }
+            report(k->name, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        }
+
+        SwsContext* sws = sws_getContext(src->width, src->height, AV_PIX_FMT_YUV420P, dst->width, dst->height,
+                                         AV_PIX_FMT_YUV420P, SWS_AREA, nullptr, nullptr, nullptr);
+        if (sws) {
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < iterations; i++) {
+                sws_scale(sws, src->data, src->linesize, 0, src->height, dst->data, dst->linesize);
+            }
+            report("swscale(area)", std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+            sws_freeContext(sws);
+        }
+    }
+
+    av_frame_free(&src);
+    av_frame_free(&dst);
+}
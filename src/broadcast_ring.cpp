@@ -0,0 +1,156 @@
+//
+// Created by Jianing on 2026/01/21.
+//
+#include "broadcast_ring.h"
+#include <iostream>
+#include <algorithm>
+
+BroadcastFrameRing::BroadcastFrameRing(uint32_t capacity) {
+    slots.resize(std::max<uint32_t>(capacity, 1));
+    for (auto& slot : slots) {
+        slot.frame = av_frame_alloc();
+        if (!slot.frame) std::cerr << "[BroadcastRing] 错误：av_frame_alloc 分配失败！" << std::endl;
+    }
+}
+
+BroadcastFrameRing::~BroadcastFrameRing() {
+    std::lock_guard<std::mutex> lock(mtx);
+    for (auto& slot : slots) {
+        av_frame_free(&slot.frame);
+    }
+}
+
+int BroadcastFrameRing::add_consumer(const std::string& name, bool lossy) {
+    std::lock_guard<std::mutex> lock(mtx);
+    Consumer c;
+    c.stats.name = name;
+    c.stats.lossy = lossy;
+    c.cursor = write_seq;
+    consumers.push_back(c);
+    return static_cast<int>(consumers.size()) - 1;
+}
+
+void BroadcastFrameRing::remove_consumer(int id) {
+    std::lock_guard<std::mutex> lock(mtx);
+    if (id < 0 || id >= static_cast<int>(consumers.size()) || !consumers[id].active) {
+        return;
+    }
+    Consumer& c = consumers[id];
+    release_range(c, write_seq);
+    c.cursor = write_seq;
+    c.active = false;
+    not_full.notify_all();
+    not_empty.notify_all();
+}
+
+void BroadcastFrameRing::release_slot(uint64_t seq) {
+    Slot& slot = slots[seq % slots.size()];
+    if (--slot.pending == 0) {
+        av_frame_unref(slot.frame);  // 最后一个消费者释放后槽位即可回收
+    }
+}
+
+void BroadcastFrameRing::release_range(Consumer& c, uint64_t until) {
+    for (uint64_t seq = c.cursor; seq < until; seq++) {
+        release_slot(seq);
+    }
+}
+
+bool BroadcastFrameRing::push(const AVFrame* frame) {
+    std::unique_lock<std::mutex> lock(mtx);
+    const uint64_t cap = slots.size();
+
+    // 等待所有普通消费者至少读完即将被覆盖的那个槽位
+    not_full.wait(lock, [&]() {
+        if (is_flush) return true;
+        for (const auto& c : consumers) {
+            if (c.active && !c.stats.lossy && write_seq - c.cursor >= cap) return false;
+        }
+        return true;
+    });
+    if (is_flush) {
+        return false;
+    }
+
+    // 有损消费者落后整整一圈：跳到覆盖后仍保留的最旧一帧
+    for (auto& c : consumers) {
+        if (c.active && c.stats.lossy && write_seq - c.cursor >= cap) {
+            uint64_t to = write_seq - cap + 1;
+            c.stats.skipped += to - c.cursor;
+            release_range(c, to);
+            c.cursor = to;
+        }
+    }
+
+    Slot& slot = slots[write_seq % cap];
+    av_frame_unref(slot.frame);
+    int ret = av_frame_ref(slot.frame, frame);
+    if (ret < 0) {
+        char err_buf[1024];
+        av_strerror(ret, err_buf, sizeof(err_buf));
+        std::cerr << "[BroadcastRing] 错误：av_frame_ref 失败：" << err_buf << std::endl;
+        return false;
+    }
+    slot.pending = 0;
+    for (const auto& c : consumers) {
+        if (c.active) slot.pending++;
+    }
+    if (slot.pending == 0) {
+        av_frame_unref(slot.frame);  // 没有消费者：不保留
+    }
+    write_seq++;
+
+    for (auto& c : consumers) {
+        if (c.active) {
+            c.stats.lag = write_seq - c.cursor;
+            c.stats.max_lag = std::max(c.stats.max_lag, c.stats.lag);
+        }
+    }
+    not_empty.notify_all();
+    return true;
+}
+
+bool BroadcastFrameRing::pop(int id, AVFrame* dst) {
+    std::unique_lock<std::mutex> lock(mtx);
+    if (id < 0 || id >= static_cast<int>(consumers.size())) {
+        return false;
+    }
+    Consumer& c = consumers[id];
+    not_empty.wait(lock, [&]() { return c.cursor < write_seq || is_flush || !c.active; });
+    if (!c.active || c.cursor >= write_seq) {
+        return false;
+    }
+
+    av_frame_unref(dst);
+    int ret = av_frame_ref(dst, slots[c.cursor % slots.size()].frame);
+    release_slot(c.cursor);
+    c.cursor++;
+    c.stats.consumed++;
+    c.stats.lag = write_seq - c.cursor;
+    not_full.notify_one();  // 只有一个生产者
+    return ret >= 0;
+}
+
+void BroadcastFrameRing::flush() {
+    std::lock_guard<std::mutex> lock(mtx);
+    is_flush = true;
+    not_full.notify_all();
+    not_empty.notify_all();
+}
+
+std::vector<BroadcastFrameRing::ConsumerStats> BroadcastFrameRing::stats() {
+    std::lock_guard<std::mutex> lock(mtx);
+    std::vector<ConsumerStats> out;
+    for (const auto& c : consumers) {
+        out.push_back(c.stats);
+    }
+    return out;
+}
+
+void BroadcastFrameRing::print_stats() {
+    for (const auto& s : stats()) {
+        std::cout << "[BroadcastRing Info] " << s.name << (s.lossy ? "（有损）" : "")
+                  << ": 读取 " << s.consumed << " 帧，跳过 " << s.skipped
+                  << " 帧，最大落后 " << s.max_lag << " 帧\n";
+    }
+}
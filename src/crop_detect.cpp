@@ -0,0 +1,210 @@
+//
+// Created by Jianing on 2026/01/27.
+//
+#include "crop_detect.h"
+#include "pixfmt_kernels.h"
+#include "keyframe_sampler.h"
+#include <iostream>
+#include <vector>
+#include <algorithm>
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#include <libavutil/pixdesc.h>
+}
+
+namespace {
+
+// 样本帧中画面内容所在范围 [top, bottom) x [left, right)
+struct ContentBox {
+    int top = 0, bottom = 0, left = 0, right = 0;
+};
+
+// 亮度平面为8位data[0]的格式才检测（YUV平面/半平面）
+bool luma_scannable(const AVFrame* frame) {
+    const AVPixFmtDescriptor* desc = av_pix_fmt_desc_get(static_cast<AVPixelFormat>(frame->format));
+    return desc && !(desc->flags & (AV_PIX_FMT_FLAG_RGB | AV_PIX_FMT_FLAG_HWACCEL | AV_PIX_FMT_FLAG_PAL)) &&
+           desc->nb_components >= 3 && desc->comp[0].plane == 0 && desc->comp[0].step == 1 &&
+           desc->comp[0].depth == 8;
+}
+
+// 求一帧的内容范围，整帧都是黑的（片头黑场）返回false
+bool find_content(const PixFmtKernels& k, const AVFrame* frame, int black_level, ContentBox* box) {
+    const int w = frame->width;
+    const int h = frame->height;
+    const uint8_t* luma = frame->data[0];
+    const int ls = frame->linesize[0];
+    // 行均值 > black_level 等价于行和 > black_level * w；行和用对全零行的SAD求得
+    const std::vector<uint8_t> zeros(w, 0);
+    const uint32_t row_limit = static_cast<uint32_t>(black_level) * w;
+    auto row_has_content = [&](int y) {
+        return k.sad_row(luma + static_cast<ptrdiff_t>(y) * ls, zeros.data(), w) > row_limit;
+    };
+
+    int top = 0;
+    while (top < h && !row_has_content(top)) top++;
+    if (top == h) {
+        return false;
+    }
+    int bottom = h;
+    while (bottom > top && !row_has_content(bottom - 1)) bottom--;
+
+    // 只在有内容的行范围内按列累加
+    std::vector<uint32_t> cols(w, 0);
+    for (int y = top; y < bottom; y++) {
+        k.accumulate_row(luma + static_cast<ptrdiff_t>(y) * ls, cols.data(), w);
+    }
+    const uint64_t col_limit = static_cast<uint64_t>(black_level) * (bottom - top);
+    int left = 0;
+    while (left < w && cols[left] <= col_limit) left++;
+    int right = w;
+    while (right > left && cols[right - 1] <= col_limit) right--;
+    if (left == right) {
+        return false;
+    }
+
+    *box = {top, bottom, left, right};
+    return true;
+}
+
+// 一个方向上的裁剪量：取偶数（向内容外侧），太小不裁，再让出部分黑边使剩余尺寸为round的倍数
+void settle_axis(int full, int round, int min_border, int* lo, int* hi) {
+    *lo &= ~1;
+    *hi &= ~1;
+    if (*lo + *hi < min_border) {
+        *lo = *hi = 0;
+        return;
+    }
+    int size = full - *lo - *hi;
+    int target = round > 1 ? std::min(full, (size + round - 1) / round * round) : size;
+    int extra = target - size;
+    int give_lo = std::min(*lo, (extra / 2) & ~1);
+    int give_hi = std::min(*hi, extra - give_lo);
+    give_lo = std::min(*lo, extra - give_hi);
+    *lo -= give_lo;
+    *hi -= give_hi;
+}
+
+} // namespace
+
+bool detect_black_borders(const char* input_file, const CropDetectOptions& opts, CropRect* crop) {
+    *crop = CropRect();
+
+    AVFormatContext* fmt_ctx = nullptr;
+    if (avformat_open_input(&fmt_ctx, input_file, nullptr, nullptr) < 0) {
+        std::cerr << "[CropDetect Error] 打开输入文件失败: " << input_file << "\n";
+        return false;
+    }
+    if (avformat_find_stream_info(fmt_ctx, nullptr) < 0) {
+        std::cerr << "[CropDetect Error] 获取媒体流信息失败\n";
+        avformat_close_input(&fmt_ctx);
+        return false;
+    }
+
+    AVCodec* decoder = nullptr;  // FFmpeg 4.4的av_find_best_stream要求非const
+    int stream_idx = av_find_best_stream(fmt_ctx, AVMEDIA_TYPE_VIDEO, -1, -1, &decoder, 0);
+    if (stream_idx < 0 || !decoder) {
+        std::cerr << "[CropDetect Error] 未找到视频流\n";
+        avformat_close_input(&fmt_ctx);
+        return false;
+    }
+    AVStream* stream = fmt_ctx->streams[stream_idx];
+
+    AVCodecContext* dec_ctx = avcodec_alloc_context3(decoder);
+    if (!dec_ctx || avcodec_parameters_to_context(dec_ctx, stream->codecpar) < 0) {
+        std::cerr << "[CropDetect Error] 初始化解码器上下文失败\n";
+        avcodec_free_context(&dec_ctx);
+        avformat_close_input(&fmt_ctx);
+        return false;
+    }
+    dec_ctx->skip_frame = AVDISCARD_NONKEY;
+    dec_ctx->thread_type = FF_THREAD_SLICE;
+    if (avcodec_open2(dec_ctx, decoder, nullptr) < 0) {
+        std::cerr << "[CropDetect Error] 打开视频解码器失败\n";
+        avcodec_free_context(&dec_ctx);
+        avformat_close_input(&fmt_ctx);
+        return false;
+    }
+
+    // 取样范围：片头sample_seconds内（流时间基），时长未知时按sample_seconds
+    int64_t start = stream->start_time != AV_NOPTS_VALUE ? stream->start_time : 0;
+    int64_t span = av_rescale_q(static_cast<int64_t>(opts.sample_seconds * AV_TIME_BASE), AV_TIME_BASE_Q,
+                                stream->time_base);
+    int64_t duration = stream_duration(fmt_ctx, stream);
+    if (duration > 0) {
+        span = std::min(span, duration);
+    }
+
+    const PixFmtKernels& k = pixfmt_kernels();
+    const int samples = std::max(opts.samples, 1);
+    AVFrame* frame = av_frame_alloc();
+    int width = 0, height = 0;
+    int used = 0, black = 0;
+    ContentBox content;
+
+    KeyframeSampler sampler(fmt_ctx, dec_ctx, stream_idx, start, span, samples);
+    KeyframeSample got;
+    while (frame && (got = sampler.next(frame)) != KeyframeSample::Done) {
+        if (got == KeyframeSample::Failed) {
+            continue;
+        }
+        // 多个取样点落在同一GOP时只算一次
+        if (got == KeyframeSample::Repeated || !luma_scannable(frame) || (width && (frame->width != width || frame->height != height))) {
+            av_frame_unref(frame);
+            continue;
+        }
+        width = frame->width;
+        height = frame->height;
+
+        ContentBox box;
+        if (!find_content(k, frame, opts.black_level, &box)) {
+            black++;
+        } else if (used++ == 0) {
+            content = box;
+        } else {
+            content.top = std::min(content.top, box.top);
+            content.bottom = std::max(content.bottom, box.bottom);
+            content.left = std::min(content.left, box.left);
+            content.right = std::max(content.right, box.right);
+        }
+        av_frame_unref(frame);
+    }
+
+    av_frame_free(&frame);
+    avcodec_free_context(&dec_ctx);
+    avformat_close_input(&fmt_ctx);
+
+    if (used == 0) {
+        std::cout << "[CropDetect Info] 没有可用的取样帧（黑场 " << black << " 帧），不裁剪\n";
+        return false;
+    }
+
+    crop->top = content.top;
+    crop->bottom = height - content.bottom;
+    crop->left = content.left;
+    crop->right = width - content.right;
+    settle_axis(height, opts.round, opts.min_border, &crop->top, &crop->bottom);
+    settle_axis(width, opts.round, opts.min_border, &crop->left, &crop->right);
+
+    // 【一次性信息】保留
+    int out_w = width - crop->left - crop->right;
+    int out_h = height - crop->top - crop->bottom;
+    std::cout << "[CropDetect Info] 取样 " << used << " 帧（跳过黑场 " << black << " 帧）：" << width << "x"
+              << height << " → " << out_w << "x" << out_h << "（上" << crop->top << " 下" << crop->bottom
+              << " 左" << crop->left << " 右" << crop->right << "，面积 "
+              << 100.0 * out_w * out_h / (static_cast<double>(width) * height) << "%）\n";
+    return true;
+}
+
+int apply_crop(AVFrame* frame, const CropRect& crop) {
+    if (crop.left + crop.right >= frame->width || crop.top + crop.bottom >= frame->height) {
+        return AVERROR(EINVAL);
+    }
+    frame->crop_top = crop.top;
+    frame->crop_bottom = crop.bottom;
+    frame->crop_left = crop.left;
+    frame->crop_right = crop.right;
+    // UNALIGNED：按要求的偏移精确裁剪（偏移都是偶数，色度平面同样整除）
+    return av_frame_apply_cropping(frame, AV_FRAME_CROP_UNALIGNED);
+}
@@ -3,6 +3,9 @@
 //
 #include "demux.h"
 #include <iostream>
+#include <thread>
+#include <chrono>
+#include <algorithm>
 
 extern "C" {
 #include <libavformat/avformat.h>
@@ -10,14 +13,41 @@ extern "C" {
 #include <libavutil/avutil.h>
 }
 
+std::vector<int64_t> stream_keyframe_index(const AVStream* st) {
+    std::vector<int64_t> keys;
+    for (int i = 0; i < st->nb_index_entries; i++) {
+        const AVIndexEntry& e = st->index_entries[i];
+        if ((e.flags & AVINDEX_KEYFRAME) && e.timestamp != AV_NOPTS_VALUE) {
+            keys.push_back(e.timestamp);
+        }
+    }
+    std::sort(keys.begin(), keys.end());
+    return keys;
+}
+
 // 解封装线程实现
-void demux_thread(AVFormatContext* fmt_ctx, int video_stream_idx, int audio_stream_idx) {
+void demux_thread(AVFormatContext* fmt_ctx, int video_stream_idx, int audio_stream_idx, DemuxOptions opts) {
     AVPacket pkt;
+    int64_t pace_first_dts = AV_NOPTS_VALUE;
+    auto pace_start = std::chrono::steady_clock::now();
 //    std::cout << "start demux!\n";
 
     // 循环读取媒体包
     while (av_read_frame(fmt_ctx, &pkt) >= 0) {
         if (pkt.stream_index == video_stream_idx) {
+            // 实时速度：等到该Packet的dts（相对第一个）对应的墙钟时刻
+            if (opts.pace && pkt.dts != AV_NOPTS_VALUE) {
+                if (pace_first_dts == AV_NOPTS_VALUE) {
+                    pace_first_dts = pkt.dts;
+                    pace_start = std::chrono::steady_clock::now();
+                }
+                double offset = (pkt.dts - pace_first_dts) * av_q2d(fmt_ctx->streams[video_stream_idx]->time_base);
+                std::this_thread::sleep_until(pace_start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                        std::chrono::duration<double>(offset)));
+            }
+            if (opts.latency) {
+                opts.latency->on_capture(pkt.pts != AV_NOPTS_VALUE ? pkt.pts : pkt.dts);
+            }
             AVPacket video_pkt;
             av_packet_ref(&video_pkt, &pkt);
             g_video_pkt_queue.push(video_pkt);
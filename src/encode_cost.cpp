@@ -0,0 +1,346 @@
+//
+// Created by Jianing on 2026/01/31.
+//
+#include "encode_cost.h"
+#include "quality_search.h"
+#include "job_stats.h"
+#include "json_util.h"
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+}
+
+namespace {
+
+// 包大小统计
+struct PacketStats {
+    int64_t count = 0;
+    double sum = 0;
+    double sum_sq = 0;
+
+    void add(int size) {
+        count++;
+        sum += size;
+        sum_sq += static_cast<double>(size) * size;
+    }
+    double mean() const { return count > 0 ? sum / count : 0.0; }
+    double cv() const {
+        if (count < 2 || sum <= 0) return 0.0;
+        double m = mean();
+        return std::sqrt(std::max(sum_sq / count - m * m, 0.0)) / m;
+    }
+};
+
+// 视频包大小：容器索引覆盖每一帧（MP4等）时直接读索引，否则（无索引、MKV只索引关键帧等）
+// 只解封装不解码地扫一遍
+PacketStats collect_packet_stats(AVFormatContext* fmt_ctx, int stream_idx, int64_t expected_frames) {
+    PacketStats stats;
+    AVStream* stream = fmt_ctx->streams[stream_idx];
+    for (int i = 0; i < stream->nb_index_entries; i++) {
+        stats.add(stream->index_entries[i].size);
+    }
+    if (stats.count > 0 && stats.count * 2 >= expected_frames) {
+        return stats;
+    }
+    stats = PacketStats();
+
+    for (unsigned int i = 0; i < fmt_ctx->nb_streams; i++) {
+        fmt_ctx->streams[i]->discard = static_cast<int>(i) == stream_idx ? AVDISCARD_DEFAULT : AVDISCARD_ALL;
+    }
+    AVPacket* pkt = av_packet_alloc();
+    while (pkt && av_read_frame(fmt_ctx, pkt) >= 0) {
+        if (pkt->stream_index == stream_idx) {
+            stats.add(pkt->size);
+        }
+        av_packet_unref(pkt);
+    }
+    av_packet_free(&pkt);
+    return stats;
+}
+
+// 试编码：返回编码全部帧（含冲刷）占用的CPU秒数，失败返回负数
+double timed_encode(const EncoderProfile& profile, int width, int height, AVRational time_base,
+                    const std::vector<AVFrame*>& frames) {
+    AVCodecContext* enc_ctx = open_video_encoder(profile, width, height, time_base);
+    AVFrame* frame = av_frame_alloc();
+    AVPacket* pkt = av_packet_alloc();
+    double seconds = -1.0;
+    if (enc_ctx && frame && pkt) {
+        double cpu_start = process_cpu_seconds();
+        for (size_t i = 0; i < frames.size(); i++) {
+            if (av_frame_ref(frame, frames[i]) < 0) {
+                continue;
+            }
+            frame->pts = static_cast<int64_t>(i);
+            frame->pict_type = AV_PICTURE_TYPE_NONE;
+            avcodec_send_frame(enc_ctx, frame);
+            av_frame_unref(frame);
+            while (avcodec_receive_packet(enc_ctx, pkt) >= 0) {
+                av_packet_unref(pkt);
+            }
+        }
+        avcodec_send_frame(enc_ctx, nullptr);
+        while (avcodec_receive_packet(enc_ctx, pkt) >= 0) {
+            av_packet_unref(pkt);
+        }
+        seconds = process_cpu_seconds() - cpu_start;
+    }
+    av_packet_free(&pkt);
+    av_frame_free(&frame);
+    avcodec_free_context(&enc_ctx);
+    return seconds;
+}
+
+// CSV字段：含逗号、引号或换行时加引号，内部引号写两次
+std::string csv_field(const std::string& s) {
+    if (s.find_first_of(",\"\r\n") == std::string::npos) {
+        return s;
+    }
+    std::string out = "\"";
+    for (char c : s) {
+        if (c == '"') {
+            out += '"';
+        }
+        out += c;
+    }
+    return out + "\"";
+}
+
+// 按CSV规则拆分一行（支持引号字段）
+std::vector<std::string> split_csv_line(const std::string& line) {
+    std::vector<std::string> fields;
+    std::string field;
+    bool quoted = false;
+    for (size_t i = 0; i < line.size(); i++) {
+        char c = line[i];
+        if (quoted) {
+            if (c == '"' && i + 1 < line.size() && line[i + 1] == '"') {
+                field += '"';
+                i++;
+            } else if (c == '"') {
+                quoted = false;
+            } else {
+                field += c;
+            }
+        } else if (c == '"') {
+            quoted = true;
+        } else if (c == ',') {
+            fields.push_back(field);
+            field.clear();
+        } else {
+            field += c;
+        }
+    }
+    fields.push_back(field);
+    return fields;
+}
+
+// 历史记录一行：input,profile,width,height,frames,predicted,actual（input按CSV规则加引号）
+struct HistoryRow {
+    std::string profile;
+    double predicted = 0;
+    double actual = 0;
+};
+
+// 读取同一配置最近window条有效记录
+std::vector<HistoryRow> load_history(const std::string& path, const std::string& profile, int window) {
+    std::vector<HistoryRow> rows;
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line)) {
+        std::vector<std::string> fields = split_csv_line(line);
+        if (fields.size() != 7 || fields[1] != profile) {
+            continue;  // 表头、其他配置或损坏的行
+        }
+        HistoryRow row;
+        row.profile = fields[1];
+        row.predicted = std::atof(fields[5].c_str());
+        row.actual = std::atof(fields[6].c_str());
+        if (row.predicted > 0 && row.actual > 0) {
+            rows.push_back(row);
+        }
+    }
+    if (static_cast<int>(rows.size()) > window) {
+        rows.erase(rows.begin(), rows.end() - window);
+    }
+    return rows;
+}
+
+bool write_cost_json(const std::string& filename, const CostEstimate& e) {
+    std::ofstream out(filename);
+    if (!out.is_open()) {
+        std::cerr << "[EncodeCost Error] 无法打开输出文件: " << filename << "\n";
+        return false;
+    }
+    out << "{\n"
+        << "  \"input\": \"" << json_escape(e.input) << "\",\n"
+        << "  \"profile\": \"" << json_escape(e.profile) << "\",\n"
+        << "  \"width\": " << e.width << ",\n"
+        << "  \"height\": " << e.height << ",\n"
+        << "  \"duration\": " << e.duration << ",\n"
+        << "  \"frames\": " << e.frames << ",\n"
+        << "  \"avg_packet_bytes\": " << e.avg_packet_bytes << ",\n"
+        << "  \"packet_bytes_cv\": " << e.packet_bytes_cv << ",\n"
+        << "  \"sample_frames\": " << e.sample_frames << ",\n"
+        << "  \"sample_packet_bytes\": " << e.sample_packet_bytes << ",\n"
+        << "  \"decode_cpu_per_frame\": " << e.decode_cpu_per_frame << ",\n"
+        << "  \"encode_cpu_per_frame\": " << e.encode_cpu_per_frame << ",\n"
+        << "  \"complexity\": " << e.complexity << ",\n"
+        << "  \"calibration\": " << e.calibration << ",\n"
+        << "  \"calibration_samples\": " << e.calibration_samples << ",\n"
+        << "  \"predicted_cpu_seconds\": " << e.predicted_cpu_seconds << "\n"
+        << "}\n";
+    return out.good();
+}
+
+} // namespace
+
+bool predict_encode_cost(const char* input_file, const EncoderProfile& profile, int width, int height,
+                         AVRational time_base, const CostPredictOptions& opts, CostEstimate* estimate) {
+    CostEstimate e;
+    e.input = input_file;
+    e.profile = profile.name;
+    e.width = width;
+    e.height = height;
+
+    AVFormatContext* fmt_ctx = nullptr;
+    if (avformat_open_input(&fmt_ctx, input_file, nullptr, nullptr) < 0 ||
+        avformat_find_stream_info(fmt_ctx, nullptr) < 0) {
+        std::cerr << "[EncodeCost Error] 打开输入文件失败: " << input_file << "\n";
+        avformat_close_input(&fmt_ctx);
+        return false;
+    }
+    int stream_idx = av_find_best_stream(fmt_ctx, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+    if (stream_idx < 0) {
+        std::cerr << "[EncodeCost Error] 未找到视频流\n";
+        avformat_close_input(&fmt_ctx);
+        return false;
+    }
+    AVStream* stream = fmt_ctx->streams[stream_idx];
+    int64_t start = stream->start_time != AV_NOPTS_VALUE ? stream->start_time : 0;
+    int64_t duration_ts = stream->duration;
+    if (duration_ts <= 0 && fmt_ctx->duration > 0) {
+        duration_ts = av_rescale_q(fmt_ctx->duration, AV_TIME_BASE_Q, stream->time_base);
+    }
+    e.duration = duration_ts > 0 ? duration_ts * av_q2d(stream->time_base) : 0.0;
+    AVRational frame_rate = av_guess_frame_rate(fmt_ctx, stream, nullptr);
+    int64_t expected_frames = frame_rate.num > 0 && frame_rate.den > 0
+                              ? static_cast<int64_t>(e.duration * av_q2d(frame_rate) + 0.5) : 0;
+
+    PacketStats packets = collect_packet_stats(fmt_ctx, stream_idx, expected_frames);
+    avformat_close_input(&fmt_ctx);
+    e.avg_packet_bytes = packets.mean();
+    e.packet_bytes_cv = packets.cv();
+    e.frames = packets.count > 0 ? packets.count : expected_frames;
+    if (e.frames == 0) {
+        std::cerr << "[EncodeCost Error] 无法得到帧数（无索引且时长未知）\n";
+        return false;
+    }
+
+    // 片中取一段：解码 + 裁剪/缩放与正式流程相同，分别计CPU时间
+    std::vector<AVFrame*> frames;
+    int64_t sample_bytes = 0;
+    double cpu_start = process_cpu_seconds();
+    bool decoded = decode_sample_frames(input_file, start + std::max<int64_t>(duration_ts, 0) / 2,
+                                        std::max(opts.sample_frames, 1), width, height, opts.crop, &frames,
+                                        &sample_bytes);
+    double decode_seconds = process_cpu_seconds() - cpu_start;
+    double encode_seconds = decoded ? timed_encode(profile, width, height, time_base, frames) : -1.0;
+    e.sample_frames = static_cast<int>(frames.size());
+    for (AVFrame*& frame : frames) {
+        av_frame_free(&frame);
+    }
+    if (encode_seconds < 0) {
+        std::cerr << "[EncodeCost Error] 试编码失败\n";
+        return false;
+    }
+    e.decode_cpu_per_frame = decode_seconds / e.sample_frames;
+    e.encode_cpu_per_frame = encode_seconds / e.sample_frames;
+    e.sample_packet_bytes = static_cast<double>(sample_bytes) / e.sample_frames;
+
+    // 试编码段只代表片中一处：按全片与该段源包大小之比修正（编码耗时随内容复杂度亚线性增长）
+    if (e.sample_packet_bytes > 0 && e.avg_packet_bytes > 0) {
+        e.complexity = std::min(std::max(std::sqrt(e.avg_packet_bytes / e.sample_packet_bytes), 0.5), 2.0);
+    }
+
+    // 历史校准：同一配置实测/预测的中位数，吸收试编码未覆盖的开销（复用、队列、其他阶段）
+    if (!opts.history_file.empty()) {
+        std::vector<HistoryRow> rows = load_history(opts.history_file, profile.name, opts.history_window);
+        std::vector<double> ratios;
+        for (const auto& row : rows) {
+            ratios.push_back(row.actual / row.predicted);
+        }
+        if (!ratios.empty()) {
+            std::sort(ratios.begin(), ratios.end());
+            e.calibration = ratios[ratios.size() / 2];
+            e.calibration_samples = static_cast<int>(ratios.size());
+        }
+    }
+
+    double raw_predicted = e.frames * (e.decode_cpu_per_frame + e.encode_cpu_per_frame) * e.complexity;
+    e.predicted_cpu_seconds = raw_predicted * e.calibration;
+    *estimate = e;
+
+    // 【一次性信息】保留
+    std::cout << "[EncodeCost Info] " << width << "x" << height << "，" << e.frames << " 帧（" << e.duration
+              << " 秒），试编码 " << e.sample_frames << " 帧：解码 " << e.decode_cpu_per_frame * 1000
+              << "ms/帧，编码 " << e.encode_cpu_per_frame * 1000 << "ms/帧，复杂度修正 " << e.complexity
+              << "，校准 " << e.calibration << "（" << e.calibration_samples << " 条）→ 预计 "
+              << estimate->predicted_cpu_seconds << " CPU秒\n";
+    if (!opts.json_file.empty()) {
+        write_cost_json(opts.json_file, *estimate);
+    }
+    return true;
+}
+
+void record_encode_cost(const CostPredictOptions& opts, const CostEstimate& estimate, double actual_cpu_seconds) {
+    double error = estimate.predicted_cpu_seconds > 0
+                   ? (estimate.predicted_cpu_seconds - actual_cpu_seconds) / actual_cpu_seconds : 0.0;
+    std::cout << "[EncodeCost Info] 实际 " << actual_cpu_seconds << " CPU秒，预测 " << estimate.predicted_cpu_seconds
+              << "（误差 " << error * 100 << "%）\n";
+    if (opts.history_file.empty() || actual_cpu_seconds <= 0) {
+        return;
+    }
+
+    // 记录未校准的预测值：校准系数由历史重新求得，不会自我叠加
+    double raw_predicted = estimate.predicted_cpu_seconds / estimate.calibration;
+    bool exists = std::ifstream(opts.history_file).good();
+    std::ofstream out(opts.history_file, std::ios::app);
+    if (!out.is_open()) {
+        std::cerr << "[EncodeCost Warn] 无法写入历史文件: " << opts.history_file << "\n";
+        return;
+    }
+    if (!exists) {
+        out << "input,profile,width,height,frames,predicted,actual\n";
+    }
+    out << csv_field(estimate.input) << ',' << csv_field(estimate.profile) << ',' << estimate.width << ',' << estimate.height << ','
+        << estimate.frames << ',' << raw_predicted << ',' << actual_cpu_seconds << '\n';
+    out.close();
+
+    // 最近若干条按当时的校准方式（其之前记录的中位数）回放，得到可比较的误差
+    std::vector<HistoryRow> rows = load_history(opts.history_file, estimate.profile, opts.history_window);
+    double abs_error_sum = 0;
+    int scored = 0;
+    std::vector<double> ratios;
+    for (const auto& row : rows) {
+        if (!ratios.empty()) {
+            std::vector<double> sorted = ratios;
+            std::sort(sorted.begin(), sorted.end());
+            double predicted = row.predicted * sorted[sorted.size() / 2];
+            abs_error_sum += std::fabs(predicted - row.actual) / row.actual;
+            scored++;
+        }
+        ratios.push_back(row.actual / row.predicted);
+    }
+    if (scored > 0) {
+        std::cout << "[EncodeCost Info] 配置 " << estimate.profile << " 最近 " << scored
+                  << " 次预测的平均绝对百分比误差 " << abs_error_sum / scored * 100 << "%\n";
+    }
+}
@@ -0,0 +1,185 @@
+//
+// Created by Jianing on 2026/01/29.
+//
+#include "encoder_profile.h"
+#include <iostream>
+#include <vector>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavutil/dict.h>
+#include <libavutil/opt.h>
+#include <libavutil/error.h>
+}
+
+namespace {
+
+EncoderProfile make_profile(const char* name, const char* codec, const char* preset, int gop_size) {
+    EncoderProfile profile;
+    profile.name = name;
+    profile.codec = codec;
+    profile.preset = preset;
+    profile.gop_size = gop_size;
+    return profile;
+}
+
+// 内置配置，按速度从快到慢排列
+std::vector<EncoderProfile> builtin_profiles() {
+    std::vector<EncoderProfile> profiles;
+
+    // 原先固定的设置：MPEG4、1Mbps、GOP 10、单线程、mp4v
+    EncoderProfile mpeg4 = make_profile("mpeg4", "mpeg4", "", 10);
+    mpeg4.codec_tag = 0x7634706d;  // 'mp4v'的小端表示
+    profiles.push_back(mpeg4);
+
+    // 速度优先：按片多线程，缩小运动搜索范围，拉长GOP
+    EncoderProfile mpeg4_fast = mpeg4;
+    mpeg4_fast.name = "mpeg4_fast";
+    mpeg4_fast.gop_size = 50;
+    mpeg4_fast.threads = 0;
+    mpeg4_fast.options = "me_range=16";
+    profiles.push_back(mpeg4_fast);
+
+    // 体积优先：率失真宏块决策 + trellis量化 + 4MV/AC预测 + 2个B帧
+    EncoderProfile mpeg4_hq = mpeg4_fast;
+    mpeg4_hq.name = "mpeg4_hq";
+    mpeg4_hq.max_b_frames = 2;
+    mpeg4_hq.options = "mbd=rd:trellis=1:flags=+mv4+aic";
+    profiles.push_back(mpeg4_hq);
+
+    // 固定量化参数（qscale 4），码率随内容变化
+    EncoderProfile mpeg4_q = mpeg4_fast;
+    mpeg4_q.max_b_frames = 2;
+    mpeg4_q.name = "mpeg4_q";
+    mpeg4_q.rate_control = RateControl::ConstQuality;
+    mpeg4_q.quality = 4;
+    profiles.push_back(mpeg4_q);
+
+    // libx264（FFmpeg需带--enable-libx264）：恒定质量crf 23，帧级多线程，ultrafast以外3个B帧
+    for (const char* preset : {"ultrafast", "veryfast", "medium"}) {
+        EncoderProfile x264 = make_profile("", "libx264", preset, 250);
+        x264.name = std::string("x264_") + preset;
+        x264.max_b_frames = x264.preset == "ultrafast" ? 0 : 3;
+        x264.rate_control = RateControl::ConstQuality;
+        x264.threads = 0;
+        x264.global_header = true;
+        profiles.push_back(x264);
+    }
+    return profiles;
+}
+
+} // namespace
+
+bool find_encoder_profile(const std::string& name, EncoderProfile* profile) {
+    std::vector<EncoderProfile> profiles = builtin_profiles();
+    for (const auto& p : profiles) {
+        if (p.name == name) {
+            *profile = p;
+            return true;
+        }
+    }
+    std::cerr << "[EncoderProfile Error] 没有名为 " << name << " 的编码配置，可用：";
+    for (const auto& p : profiles) {
+        std::cerr << " " << p.name;
+    }
+    std::cerr << "\n";
+    return false;
+}
+
+void apply_low_latency(EncoderProfile* profile) {
+    profile->max_b_frames = 0;
+    if (profile->codec == "libx264") {
+        // zerolatency：rc-lookahead=0、sync-lookahead=0、sliced-threads，帧级多线程的额外延迟也一并去掉
+        profile->options = profile->options.empty() ? "tune=zerolatency" : profile->options + ":tune=zerolatency";
+    }
+    profile->name += "_live";
+}
+
+AVCodecContext* open_video_encoder(const EncoderProfile& profile, int width, int height, AVRational time_base) {
+    const AVCodec* encoder = avcodec_find_encoder_by_name(profile.codec.c_str());
+    if (!encoder || encoder->type != AVMEDIA_TYPE_VIDEO) {
+        std::cerr << "[VideoEncoder Error] 找不到视频编码器 " << profile.codec << "（配置 " << profile.name << "）\n";
+        return nullptr;
+    }
+
+    AVCodecContext* enc_ctx = avcodec_alloc_context3(encoder);
+    if (!enc_ctx) {
+        std::cerr << "[VideoEncoder Error] 分配视频编码器上下文失败\n";
+        return nullptr;
+    }
+
+    // 设置编码参数
+    enc_ctx->width = width;
+    enc_ctx->height = height;
+    enc_ctx->pix_fmt = AV_PIX_FMT_YUV420P;
+    enc_ctx->color_range = profile.color_range;
+    enc_ctx->time_base = time_base;
+    enc_ctx->framerate = av_inv_q(time_base);
+    enc_ctx->gop_size = profile.gop_size;
+    enc_ctx->max_b_frames = profile.max_b_frames;
+    enc_ctx->thread_count = profile.threads;
+    enc_ctx->codec_tag = profile.codec_tag;
+    if (profile.global_header) {
+        enc_ctx->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+    }
+
+    AVDictionary* options = nullptr;
+    if (!profile.options.empty() && av_dict_parse_string(&options, profile.options.c_str(), "=", ":", 0) < 0) {
+        std::cerr << "[VideoEncoder Warn] 编码选项解析失败，已忽略：" << profile.options << "\n";
+        av_dict_free(&options);
+    }
+    if (!profile.preset.empty()) {
+        if (av_opt_find(enc_ctx->priv_data, "preset", nullptr, 0, 0)) {
+            av_dict_set(&options, "preset", profile.preset.c_str(), 0);
+        } else {
+            std::cerr << "[VideoEncoder Warn] " << profile.codec << " 没有preset选项，忽略 " << profile.preset << "\n";
+        }
+    }
+    if (profile.rate_control == RateControl::ConstQuality) {
+        if (av_opt_find(enc_ctx->priv_data, "crf", nullptr, 0, 0)) {
+            av_dict_set_int(&options, "crf", profile.quality, 0);
+        } else {
+            enc_ctx->flags |= AV_CODEC_FLAG_QSCALE;
+            enc_ctx->global_quality = profile.quality * FF_QP2LAMBDA;
+        }
+    } else {
+        enc_ctx->bit_rate = profile.bit_rate;
+    }
+
+    int ret = avcodec_open2(enc_ctx, encoder, &options);
+    // avcodec_open2会取走识别的选项，剩下的是拼错或该编码器不支持的
+    AVDictionaryEntry* unused = nullptr;
+    while ((unused = av_dict_get(options, "", unused, AV_DICT_IGNORE_SUFFIX))) {
+        std::cerr << "[VideoEncoder Warn] " << profile.codec << " 不识别选项 " << unused->key << "=" << unused->value
+                  << "\n";
+    }
+    av_dict_free(&options);
+    if (ret < 0) {
+        char err_buf[1024];
+        av_strerror(ret, err_buf, sizeof(err_buf));
+        std::cerr << "[VideoEncoder Error] 打开" << profile.codec << "编码器失败：" << err_buf << "\n";
+        avcodec_free_context(&enc_ctx);
+        return nullptr;
+    }
+    return enc_ctx;
+}
+
+AVCodecParameters* make_encoder_params(const EncoderProfile& profile, int width, int height, AVRational time_base) {
+    AVCodecContext* enc_ctx = open_video_encoder(profile, width, height, time_base);
+    if (!enc_ctx) {
+        return nullptr;
+    }
+    AVCodecParameters* params = avcodec_parameters_alloc();
+    if (!params || avcodec_parameters_from_context(params, enc_ctx) < 0) {
+        std::cerr << "[VideoEncoder Error] 导出复用参数失败\n";
+        avcodec_parameters_free(&params);
+        avcodec_free_context(&enc_ctx);
+        return nullptr;
+    }
+    avcodec_free_context(&enc_ctx);
+
+    std::cout << "[VideoEncoder Info] 编码配置 " << profile.name << " 的复用参数: " << avcodec_get_name(params->codec_id)
+              << ", codec_tag=0x" << std::hex << params->codec_tag << std::dec << ", 分辨率=" << params->width << "x"
+              << params->height << ", extradata " << params->extradata_size << " 字节\n";
+    return params;
+}
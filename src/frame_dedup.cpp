@@ -0,0 +1,86 @@
+//
+// Created by Jianing on 2026/01/26.
+//
+#include "frame_dedup.h"
+#include "pixfmt_kernels.h"
+#include <algorithm>
+
+extern "C" {
+#include <libavutil/imgutils.h>
+#include <libavutil/pixdesc.h>
+}
+
+DuplicateFrameFilter::DuplicateFrameFilter(const DedupOptions& options) : opts(options) {
+    opts.threshold = std::max(opts.threshold, 0.0);
+    opts.max_run = std::max(opts.max_run, 0);
+}
+
+DuplicateFrameFilter::~DuplicateFrameFilter() {
+    av_frame_free(&last_kept);
+    av_frame_free(&last_dropped);
+}
+
+bool DuplicateFrameFilter::same_as_kept(const AVFrame* frame) const {
+    if (!last_kept || frame->width != last_kept->width || frame->height != last_kept->height ||
+        frame->format != last_kept->format) {
+        return false;
+    }
+    AVPixelFormat fmt = static_cast<AVPixelFormat>(frame->format);
+    const AVPixFmtDescriptor* desc = av_pix_fmt_desc_get(fmt);
+    int row_bytes[4] = {0};
+    if (!desc || (desc->flags & (AV_PIX_FMT_FLAG_HWACCEL | AV_PIX_FMT_FLAG_BITSTREAM)) ||
+        av_image_fill_linesizes(row_bytes, fmt, frame->width) < 0) {
+        return false;
+    }
+
+    // 各平面每行字节数与行数，得到总字节数和允许的SAD总量
+    const int planes = av_pix_fmt_count_planes(fmt);
+    int rows[4] = {0};
+    uint64_t total = 0;
+    for (int p = 0; p < planes; p++) {
+        bool chroma = (p == 1 || p == 2) && !(desc->flags & AV_PIX_FMT_FLAG_RGB);
+        rows[p] = chroma ? AV_CEIL_RSHIFT(frame->height, desc->log2_chroma_h) : frame->height;
+        total += static_cast<uint64_t>(row_bytes[p]) * rows[p];
+    }
+    const uint64_t budget = static_cast<uint64_t>(opts.threshold * static_cast<double>(total));
+
+    const PixFmtKernels& k = pixfmt_kernels();
+    uint64_t sad = 0;
+    for (int p = 0; p < planes; p++) {
+        for (int y = 0; y < rows[p]; y++) {
+            sad += k.sad_row(frame->data[p] + static_cast<ptrdiff_t>(y) * frame->linesize[p],
+                             last_kept->data[p] + static_cast<ptrdiff_t>(y) * last_kept->linesize[p], row_bytes[p]);
+            // 超出即可判定不重复：非重复帧通常在前几行就结束
+            if (sad > budget) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool DuplicateFrameFilter::is_duplicate(const AVFrame* frame) {
+    bool duplicate = (opts.max_run == 0 || run < opts.max_run) && same_as_kept(frame);
+
+    av_frame_free(&last_dropped);
+    AVFrame* ref = av_frame_alloc();
+    if (ref && av_frame_ref(ref, frame) < 0) {
+        av_frame_free(&ref);
+    }
+    if (duplicate) {
+        run++;
+        drop_count++;
+        last_dropped = ref;
+    } else {
+        run = 0;
+        av_frame_free(&last_kept);
+        last_kept = ref;
+    }
+    return duplicate;
+}
+
+AVFrame* DuplicateFrameFilter::take_tail() {
+    AVFrame* tail = last_dropped;
+    last_dropped = nullptr;
+    return tail;
+}
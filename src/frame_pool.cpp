@@ -0,0 +1,329 @@
+//
+// Created by Jianing on 2026/01/05.
+//
+#include "frame_pool.h"
+#include <iostream>
+#include <algorithm>
+#include <cstdlib>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavutil/imgutils.h>
+#include <libavutil/pixdesc.h>
+}
+
+#ifdef _WIN32
+#include <malloc.h>
+#else
+#include <sys/mman.h>
+#endif
+
+// 同时缓存的分辨率/格式组合上限
+static const size_t kMaxPoolSets = 4;
+// 页大小与大页大小（预写按4KB步进，大页按2MB取整）
+static const size_t kPageSize = 4096;
+static const size_t kHugePageSize = 2 * 1024 * 1024;
+
+namespace {
+
+enum class BackingKind { Aligned, HugeTLB };
+
+// 单块缓冲区的底层内存信息（释放时使用）
+struct Backing {
+    BackingKind kind;
+    void* base;
+    size_t length;
+};
+
+size_t round_up(size_t v, size_t a) {
+    return (v + a - 1) / a * a;
+}
+
+void* aligned_alloc_bytes(size_t align, size_t size) {
+#ifdef _WIN32
+    return _aligned_malloc(size, align);
+#else
+    void* ptr = nullptr;
+    if (posix_memalign(&ptr, align, size) != 0) {
+        return nullptr;
+    }
+    return ptr;
+#endif
+}
+
+void aligned_free_bytes(void* ptr) {
+#ifdef _WIN32
+    _aligned_free(ptr);
+#else
+    free(ptr);
+#endif
+}
+
+} // namespace
+
+FramePool::FramePool(const FramePoolOptions& options) : opts(options) {
+    // 对齐至少满足FFmpeg SIMD的要求，且必须是2的幂
+    if (opts.align < 64 || (opts.align & (opts.align - 1))) {
+        opts.align = 64;
+    }
+}
+
+FramePool::~FramePool() {
+    std::lock_guard<std::mutex> lock(mtx);
+    for (PoolSet* set : sets) {
+        for (auto& pool : set->pools) {
+            // 仍被外部引用的缓冲区在最后一次unref时才真正释放
+            av_buffer_pool_uninit(&pool);
+        }
+        delete set;
+    }
+    sets.clear();
+}
+
+void FramePool::set_prewarm_count(int count) {
+    std::lock_guard<std::mutex> lock(mtx);
+    prewarm_count = std::max(count, 0);
+}
+
+#if FF_API_BUFFER_SIZE_T
+AVBufferRef* FramePool::pool_alloc(void* opaque, int size) {
+#else
+AVBufferRef* FramePool::pool_alloc(void* opaque, size_t size) {
+#endif
+    FramePool* self = static_cast<FramePool*>(opaque);
+    const FramePoolOptions& o = self->opts;
+
+    Backing* backing = new Backing{BackingKind::Aligned, nullptr, static_cast<size_t>(size)};
+
+#ifndef _WIN32
+    if (o.huge_page == HugePageMode::HugeTLB) {
+        size_t length = round_up(size, kHugePageSize);
+        int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB;
+        if (o.prefault) {
+            flags |= MAP_POPULATE;
+        }
+        void* ptr = mmap(nullptr, length, PROT_READ | PROT_WRITE, flags, -1, 0);
+        if (ptr != MAP_FAILED) {
+            backing->kind = BackingKind::HugeTLB;
+            backing->base = ptr;
+            backing->length = length;
+        }
+        // hugetlbfs未配置预留页时失败，继续走透明大页
+    }
+
+    if (!backing->base && o.huge_page != HugePageMode::None) {
+        size_t length = round_up(size, kHugePageSize);
+        backing->base = aligned_alloc_bytes(kHugePageSize, length);
+        backing->length = length;
+#ifdef MADV_HUGEPAGE
+        if (backing->base) {
+            madvise(backing->base, length, MADV_HUGEPAGE);
+        }
+#endif
+    }
+#endif
+
+    if (!backing->base) {
+        backing->base = aligned_alloc_bytes(o.align, round_up(size, o.align));
+    }
+    if (!backing->base) {
+        std::cerr << "[FramePool] 错误：分配" << size << "字节缓冲区失败！\n";
+        delete backing;
+        return nullptr;
+    }
+
+    // 逐页写入一次，把缺页集中到预热阶段（MAP_POPULATE已完成的除外）
+    if (o.prefault && backing->kind != BackingKind::HugeTLB) {
+        volatile uint8_t* p = static_cast<uint8_t*>(backing->base);
+        for (size_t off = 0; off < backing->length; off += kPageSize) {
+            p[off] = 0;
+        }
+    }
+
+    AVBufferRef* buf = av_buffer_create(static_cast<uint8_t*>(backing->base), size,
+                                        pool_free, backing, 0);
+    if (!buf) {
+        pool_free(backing, static_cast<uint8_t*>(backing->base));
+    }
+    return buf;
+}
+
+void FramePool::pool_free(void* opaque, uint8_t* /*data*/) {
+    Backing* backing = static_cast<Backing*>(opaque);
+#ifndef _WIN32
+    if (backing->kind == BackingKind::HugeTLB) {
+        munmap(backing->base, backing->length);
+        delete backing;
+        return;
+    }
+#endif
+    aligned_free_bytes(backing->base);
+    delete backing;
+}
+
+void FramePool::prewarm(PoolSet* set, int count) {
+    // 先一次性取出count组缓冲区再全部归还，池中即保留count组已缺页的缓冲区
+    std::vector<AVBufferRef*> held;
+    held.reserve(static_cast<size_t>(count) * 4);
+    for (int n = 0; n < count; n++) {
+        for (auto& pool : set->pools) {
+            if (!pool) continue;
+            AVBufferRef* buf = av_buffer_pool_get(pool);
+            if (!buf) break;
+            held.push_back(buf);
+        }
+    }
+    for (auto& buf : held) {
+        av_buffer_unref(&buf);
+    }
+}
+
+FramePool::PoolSet* FramePool::find_or_create(int width, int height, int format, int extra_prewarm) {
+    for (size_t i = 0; i < sets.size(); i++) {
+        PoolSet* set = sets[i];
+        if (set->width == width && set->height == height && set->format == format) {
+            // 移到末尾，保持按最近使用排序
+            std::rotate(sets.begin() + i, sets.begin() + i + 1, sets.end());
+            return set;
+        }
+    }
+
+    auto pix_fmt = static_cast<AVPixelFormat>(format);
+    int linesize_int[4] = {0};
+
+    // 逐步增大宽度，直到所有平面的行宽都满足对齐（与FFmpeg默认缓冲池一致，
+    // 不单独对齐每个平面，保证linesize[0] == 2 * linesize[1]等关系成立）
+    int w = width;
+    while (true) {
+        if (av_image_fill_linesizes(linesize_int, pix_fmt, w) < 0) {
+            return nullptr;
+        }
+        int unaligned = 0;
+        for (int i = 0; i < 4; i++) {
+            unaligned |= linesize_int[i] % opts.align;
+        }
+        if (!unaligned) break;
+        w += w & ~(w - 1);
+    }
+
+    ptrdiff_t linesize[4];
+    for (int i = 0; i < 4; i++) {
+        linesize[i] = linesize_int[i];
+    }
+    size_t plane_size[4] = {0};
+    if (av_image_fill_plane_sizes(plane_size, pix_fmt, height, linesize) < 0) {
+        return nullptr;
+    }
+
+    PoolSet* set = new PoolSet();
+    set->width = width;
+    set->height = height;
+    set->format = format;
+    for (int i = 0; i < 4; i++) {
+        set->linesize[i] = linesize_int[i];
+        if (!plane_size[i]) continue;
+        // 尾部额外留出对齐余量，部分解码器/SIMD会越界读取少量字节
+        size_t pool_size = plane_size[i] + 16 + opts.align - 1;
+        set->pools[i] = av_buffer_pool_init2(static_cast<int>(pool_size), this, pool_alloc, nullptr);
+        if (!set->pools[i]) {
+            for (auto& pool : set->pools) {
+                av_buffer_pool_uninit(&pool);
+            }
+            delete set;
+            return nullptr;
+        }
+    }
+
+    if (sets.size() >= kMaxPoolSets) {
+        PoolSet* oldest = sets.front();
+        for (auto& pool : oldest->pools) {
+            av_buffer_pool_uninit(&pool);
+        }
+        delete oldest;
+        sets.erase(sets.begin());
+    }
+    sets.push_back(set);
+
+    int count = prewarm_count + extra_prewarm;
+    if (count > 0) {
+        prewarm(set, count);
+    }
+
+    std::cout << "[FramePool] 新建缓冲池: " << width << "x" << height
+              << " 格式=" << av_get_pix_fmt_name(pix_fmt)
+              << " 对齐=" << opts.align
+              << " 预热=" << count << "帧\n";
+    return set;
+}
+
+int FramePool::get_buffer(AVFrame* frame, int aligned_w, int aligned_h) {
+    if (!frame || frame->width <= 0 || frame->height <= 0 || frame->format < 0) {
+        return AVERROR(EINVAL);
+    }
+    int w = aligned_w > 0 ? aligned_w : frame->width;
+    int h = aligned_h > 0 ? aligned_h : frame->height;
+
+    std::lock_guard<std::mutex> lock(mtx);
+    PoolSet* set = find_or_create(w, h, frame->format, 0);
+    if (!set) {
+        return AVERROR(ENOMEM);
+    }
+
+    for (int i = 0; i < 4; i++) {
+        if (!set->pools[i]) {
+            frame->data[i] = nullptr;
+            frame->linesize[i] = 0;
+            continue;
+        }
+        frame->buf[i] = av_buffer_pool_get(set->pools[i]);
+        if (!frame->buf[i]) {
+            av_frame_unref(frame);
+            return AVERROR(ENOMEM);
+        }
+        // 池中缓冲区本身按opts.align对齐，平面起始地址直接可用
+        frame->data[i] = frame->buf[i]->data;
+        frame->linesize[i] = set->linesize[i];
+    }
+    for (int i = 4; i < AV_NUM_DATA_POINTERS; i++) {
+        frame->data[i] = nullptr;
+        frame->linesize[i] = 0;
+    }
+    frame->extended_data = frame->data;
+    return 0;
+}
+
+void FramePool::attach(AVCodecContext* codec_ctx) {
+    codec_ctx->opaque = this;
+    codec_ctx->get_buffer2 = FramePool::get_buffer2;
+}
+
+int FramePool::get_buffer2(AVCodecContext* codec_ctx, AVFrame* frame, int flags) {
+    FramePool* self = static_cast<FramePool*>(codec_ctx->opaque);
+    const AVPixFmtDescriptor* desc = av_pix_fmt_desc_get(static_cast<AVPixelFormat>(frame->format));
+
+    // 非DR1解码器、音频、硬件帧、调色板格式仍交给FFmpeg默认实现
+    if (!self || codec_ctx->codec_type != AVMEDIA_TYPE_VIDEO ||
+        !(codec_ctx->codec->capabilities & AV_CODEC_CAP_DR1) || !desc ||
+        (desc->flags & (AV_PIX_FMT_FLAG_HWACCEL | AV_PIX_FMT_FLAG_PAL | AV_PIX_FMT_FLAG_BITSTREAM))
+#if FF_API_PSEUDOPAL
+        || (desc->flags & AV_PIX_FMT_FLAG_PSEUDOPAL)
+#endif
+        ) {
+        return avcodec_default_get_buffer2(codec_ctx, frame, flags);
+    }
+
+    int w = frame->width;
+    int h = frame->height;
+    int linesize_align[AV_NUM_DATA_POINTERS];
+    avcodec_align_dimensions2(codec_ctx, &w, &h, linesize_align);
+
+    {
+        // 首次见到该分辨率时，按解码器参考帧/重排延迟追加预热数量
+        std::lock_guard<std::mutex> lock(self->mtx);
+        int extra = std::max(codec_ctx->refs, 1) + codec_ctx->has_b_frames;
+        if (!self->find_or_create(w, h, frame->format, extra)) {
+            return AVERROR(ENOMEM);
+        }
+    }
+    return self->get_buffer(frame, w, h);
+}
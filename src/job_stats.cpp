@@ -0,0 +1,74 @@
+//
+// Created by Jianing on 2026/01/22.
+//
+#include "job_stats.h"
+#include <iostream>
+#include <algorithm>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#endif
+
+JobStats g_job_stats;
+
+void JobStats::add_time(const std::string& key, double seconds, int64_t count) {
+    std::lock_guard<std::mutex> lock(mtx);
+    Entry& e = entries[key];
+    e.seconds += seconds;
+    e.max_seconds = std::max(e.max_seconds, seconds);
+    e.count += count;
+}
+
+void JobStats::add_count(const std::string& key, int64_t count) {
+    std::lock_guard<std::mutex> lock(mtx);
+    entries[key].count += count;
+}
+
+std::map<std::string, JobStats::Entry> JobStats::snapshot() {
+    std::lock_guard<std::mutex> lock(mtx);
+    return entries;
+}
+
+void JobStats::print() {
+    auto all = snapshot();
+    if (all.empty()) {
+        return;
+    }
+    std::cout << "[JobStats] ====== 任务统计 ======\n";
+    for (const auto& item : all) {
+        const Entry& e = item.second;
+        std::cout << "[JobStats] " << item.first << ": 次数=" << e.count;
+        if (e.seconds > 0) {
+            std::cout << " 总耗时=" << e.seconds * 1000 << "ms"
+                      << " 平均=" << (e.count > 0 ? e.seconds * 1000 / e.count : 0.0) << "ms"
+                      << " 最大=" << e.max_seconds * 1000 << "ms";
+        }
+        std::cout << "\n";
+    }
+}
+
+void JobStats::reset() {
+    std::lock_guard<std::mutex> lock(mtx);
+    entries.clear();
+}
+
+double process_cpu_seconds() {
+#ifdef _WIN32
+    FILETIME create_time, exit_time, kernel_time, user_time;
+    if (!GetProcessTimes(GetCurrentProcess(), &create_time, &exit_time, &kernel_time, &user_time)) {
+        return 0.0;
+    }
+    auto to_seconds = [](const FILETIME& t) {
+        return ((static_cast<uint64_t>(t.dwHighDateTime) << 32) | t.dwLowDateTime) * 1e-7;  // 100ns单位
+    };
+    return to_seconds(kernel_time) + to_seconds(user_time);
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0.0;
+    }
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1e-6;
+#endif
+}
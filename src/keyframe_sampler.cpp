@@ -0,0 +1,69 @@
+//
+// Created by Jianing on 2026/02/03.
+//
+#include "keyframe_sampler.h"
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#include <libavutil/avutil.h>
+}
+
+int64_t stream_duration(const AVFormatContext* fmt_ctx, const AVStream* stream) {
+    int64_t duration = stream->duration;
+    if (duration <= 0 && fmt_ctx->duration > 0) {
+        duration = av_rescale_q(fmt_ctx->duration, AV_TIME_BASE_Q, stream->time_base);
+    }
+    return duration > 0 ? duration : 0;
+}
+
+bool decode_keyframe_at(AVFormatContext* fmt_ctx, AVCodecContext* dec_ctx, int stream_idx,
+                        int64_t target_ts, AVPacket* pkt, AVFrame* frame, int64_t* key_pts) {
+    if (av_seek_frame(fmt_ctx, stream_idx, target_ts, AVSEEK_FLAG_BACKWARD) < 0) {
+        return false;
+    }
+    avcodec_flush_buffers(dec_ctx);
+
+    bool sent = false;
+    while (!sent && av_read_frame(fmt_ctx, pkt) >= 0) {
+        if (pkt->stream_index == stream_idx && (pkt->flags & AV_PKT_FLAG_KEY)) {
+            *key_pts = pkt->pts != AV_NOPTS_VALUE ? pkt->pts : pkt->dts;
+            sent = avcodec_send_packet(dec_ctx, pkt) >= 0;
+        }
+        av_packet_unref(pkt);
+    }
+    if (!sent) {
+        return false;
+    }
+
+    // 只送了一个关键帧，直接排空解码器取出该帧
+    avcodec_send_packet(dec_ctx, nullptr);
+    bool got = avcodec_receive_frame(dec_ctx, frame) >= 0;
+    avcodec_flush_buffers(dec_ctx);
+    return got;
+}
+
+KeyframeSampler::KeyframeSampler(AVFormatContext* fmt_ctx, AVCodecContext* dec_ctx, int stream_idx,
+                                 int64_t start, int64_t span, int count)
+        : fmt_ctx(fmt_ctx), dec_ctx(dec_ctx), stream_idx(stream_idx), start(start), span(span),
+          count(count), last_key_pts(AV_NOPTS_VALUE), pkt(av_packet_alloc()) {}
+
+KeyframeSampler::~KeyframeSampler() {
+    av_packet_free(&pkt);
+}
+
+KeyframeSample KeyframeSampler::next(AVFrame* frame) {
+    if (index >= count) {
+        return KeyframeSample::Done;
+    }
+    int64_t target = start + av_rescale(span, 2 * index + 1, 2 * static_cast<int64_t>(count));
+    index++;
+
+    int64_t key_pts = AV_NOPTS_VALUE;
+    if (!pkt || !decode_keyframe_at(fmt_ctx, dec_ctx, stream_idx, target, pkt, frame, &key_pts)) {
+        return KeyframeSample::Failed;
+    }
+    bool repeated = key_pts != AV_NOPTS_VALUE && key_pts == last_key_pts;
+    last_key_pts = key_pts;
+    return repeated ? KeyframeSample::Repeated : KeyframeSample::Decoded;
+}
@@ -0,0 +1,198 @@
+//
+// Created by Jianing on 2026/02/02.
+//
+#include "live_latency.h"
+#include "job_stats.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+extern "C" {
+#include <libavutil/avutil.h>
+#include <libavutil/frame.h>
+#include <libavutil/buffer.h>
+}
+
+namespace {
+
+constexpr double kBucketBase = 50e-6;   // 第一个桶的上界（秒）
+constexpr double kBucketGrowth = 1.1;
+constexpr int kBucketCount = 131;       // 50us * 1.1^130 ≈ 12s，更大的都落在最后一个桶
+constexpr size_t kMaxPending = 1024;    // 等待对应的记录最多保留这么多条（时间戳对不上的会一直留着）
+
+double bucket_upper(int index) {
+    return kBucketBase * std::pow(kBucketGrowth, index);
+}
+
+} // namespace
+
+LatencyHistogram::LatencyHistogram() : buckets(kBucketCount, 0) {}
+
+void LatencyHistogram::add(double seconds) {
+    int index = 0;
+    if (seconds > kBucketBase) {
+        index = static_cast<int>(std::ceil(std::log(seconds / kBucketBase) / std::log(kBucketGrowth)));
+        index = std::min(index, kBucketCount - 1);
+    }
+    buckets[index]++;
+    total++;
+    max_seconds = std::max(max_seconds, seconds);
+}
+
+double LatencyHistogram::percentile(double p) const {
+    if (total == 0) {
+        return 0;
+    }
+    int64_t rank = std::max<int64_t>(1, static_cast<int64_t>(std::ceil(p * total)));
+    int64_t seen = 0;
+    for (int i = 0; i < kBucketCount; i++) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            return std::min(bucket_upper(i), max_seconds);
+        }
+    }
+    return max_seconds;
+}
+
+const char* const LatencyTracker::interval_names[StageCount] = {
+    "整体（采集→写盘）", "解封装→解码输出", "解码输出→送编码", "编码", "编码输出→写盘",
+};
+
+LatencyTracker::LatencyTracker(double target_seconds, int64_t report_interval)
+        : target(target_seconds), report_interval(report_interval) {}
+
+void LatencyTracker::on_capture(int64_t src_ts) {
+    if (src_ts == AV_NOPTS_VALUE) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mtx);
+    captured.emplace(src_ts, Clock::now());
+    // 滤镜改了时间戳、解码器丢帧等情况下on_decoded永远对不上，只保留最近的一段
+    while (captured.size() > kMaxPending) {
+        captured.erase(captured.begin());
+    }
+}
+
+void LatencyTracker::on_decoded(AVFrame* frame) {
+    int64_t ts = frame->pts != AV_NOPTS_VALUE ? frame->pts : frame->best_effort_timestamp;
+    Stamps stamps{};
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto it = captured.find(ts);
+        if (it == captured.end()) {
+            return;
+        }
+        stamps.at[Demux] = it->second;
+        // 解码按显示顺序输出，更早的源时间戳不会再出现（被丢弃的帧）
+        captured.erase(captured.begin(), ++it);
+    }
+    stamps.at[DecodeOut] = Clock::now();
+
+    // 挂到帧上：av_frame_ref/av_frame_copy_props都会带上opaque_ref，经过缓冲区和滤镜/缩放不丢
+    AVBufferRef* buf = av_buffer_alloc(sizeof(Stamps));
+    if (!buf) {
+        return;
+    }
+    std::memcpy(buf->data, &stamps, sizeof(Stamps));
+    av_buffer_unref(&frame->opaque_ref);
+    frame->opaque_ref = buf;
+}
+
+void LatencyTracker::on_encode(const AVFrame* frame, int64_t enc_pts) {
+    Clock::time_point now = Clock::now();
+    std::lock_guard<std::mutex> lock(mtx);
+    if (!frame->opaque_ref || frame->opaque_ref->size != static_cast<int>(sizeof(Stamps))) {
+        untracked++;
+        return;
+    }
+    Stamps stamps;
+    std::memcpy(&stamps, frame->opaque_ref->data, sizeof(Stamps));
+    stamps.at[EncodeIn] = now;
+    encoding[enc_pts] = stamps;
+    // 编码器或复用端丢掉的Packet不会再来，只保留最近的一段
+    while (encoding.size() > kMaxPending) {
+        encoding.erase(encoding.begin());
+    }
+}
+
+void LatencyTracker::on_excluded(int64_t count) {
+    std::lock_guard<std::mutex> lock(mtx);
+    excluded += count;
+}
+
+void LatencyTracker::on_encoded(int64_t enc_pts) {
+    Clock::time_point now = Clock::now();
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = encoding.find(enc_pts);
+    if (it != encoding.end()) {
+        it->second.at[EncodeOut] = now;
+    }
+}
+
+void LatencyTracker::on_write(int64_t enc_pts) {
+    Clock::time_point now = Clock::now();
+    double latency = 0;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto it = encoding.find(enc_pts);
+        if (it == encoding.end()) {
+            return;
+        }
+        Stamps stamps = it->second;
+        encoding.erase(it);
+        stamps.at[MuxWrite] = now;
+        if (stamps.at[EncodeOut] == Clock::time_point()) {
+            stamps.at[EncodeOut] = stamps.at[EncodeIn];
+        }
+
+        latency = std::chrono::duration<double>(now - stamps.at[Demux]).count();
+        intervals[0].add(latency);
+        for (int i = DecodeOut; i < StageCount; i++) {
+            intervals[i].add(std::chrono::duration<double>(stamps.at[i] - stamps.at[i - 1]).count());
+        }
+
+        frames++;
+        if (target > 0 && latency > target) {
+            over_target++;
+            // 超标日志按2的幂次限频
+            if ((over_target & (over_target - 1)) == 0) {
+                std::cerr << "[Latency Warn] 采集→写盘延迟 " << latency * 1000 << "ms 超过目标 " << target * 1000
+                          << "ms（pts=" << enc_pts << "，累计超标 " << over_target << " 帧）\n";
+            }
+        }
+        if (report_interval > 0 && frames % report_interval == 0) {
+            print_locked();
+        }
+    }
+    g_job_stats.add_time("latency.capture_to_write", latency);
+}
+
+void LatencyTracker::print() {
+    std::lock_guard<std::mutex> lock(mtx);
+    print_locked();
+}
+
+void LatencyTracker::print_locked() {
+    if (frames == 0) {
+        std::cout << "[Latency Info] 没有可统计延迟的帧（未登记 " << untracked << " 帧，不参与统计 " << excluded
+                  << " 帧）\n";
+        return;
+    }
+    std::cout << "[Latency Info] ====== 逐帧延迟（" << frames << " 帧）======\n";
+    for (int i = 0; i < StageCount; i++) {
+        const LatencyHistogram& h = intervals[i];
+        std::cout << "[Latency Info] " << interval_names[i] << ": p50=" << h.percentile(0.5) * 1000
+                  << "ms p99=" << h.percentile(0.99) * 1000 << "ms max=" << h.max() * 1000 << "ms\n";
+    }
+    if (target > 0) {
+        std::cout << "[Latency Info] 超过目标(" << target * 1000 << "ms) " << over_target << " 帧（"
+                  << over_target * 100 / frames << "%）\n";
+    }
+    if (untracked > 0) {
+        std::cout << "[Latency Info] 未登记 " << untracked << " 帧\n";
+    }
+    if (excluded > 0) {
+        std::cout << "[Latency Info] 不参与统计 " << excluded << " 帧（并行GOP编码、重复帧消除补编的末帧）\n";
+    }
+}
@@ -12,7 +12,10 @@ extern "C" {
 
 void mux_thread(const std::string& output_file,
                 AVCodecParameters* video_enc_par,
-                AVCodecParameters* /*audio_enc_par*/)
+                AVCodecParameters* /*audio_enc_par*/,
+                AVRational video_pkt_time_base,
+                DeepCopyPacketQueue* video_pkt_queue,
+                MuxOptions opts)
 {
     std::cout << "[Mux] 开始创建输出文件: " << output_file << "\n";
 
@@ -47,14 +50,13 @@ void mux_thread(const std::string& output_file,
     }
 
     // 对于MP4容器，必须正确设置codec_tag
-    // MPEG4在MP4容器中的标准codec_tag是'mp4v' (0x7634706d)
-    // 确保codec_tag正确设置
-    if (video_stream->codecpar->codec_tag == 0) {
+    // MPEG4在MP4容器中的标准codec_tag是'mp4v' (0x7634706d)；其他编码格式由封装器按codec_id选择
+    if (video_stream->codecpar->codec_id == AV_CODEC_ID_MPEG4 && video_stream->codecpar->codec_tag == 0) {
         video_stream->codecpar->codec_tag = 0x7634706d; // 'mp4v'
     }
 
-    // 设置视频流时间基
-    video_stream->time_base = (AVRational){1, 25};
+    // 设置视频流时间基（与编码输出一致，写头时容器可能再调整）
+    video_stream->time_base = video_pkt_time_base;
 
     std::cout << "[Mux Info] 视频流配置: 分辨率="
               << video_stream->codecpar->width << "x" << video_stream->codecpar->height
@@ -78,7 +80,13 @@ void mux_thread(const std::string& output_file,
     }
 
     // 写入文件头
-    ret = avformat_write_header(out_fmt_ctx, nullptr);
+    AVDictionary* mux_options = nullptr;
+    if (opts.low_latency) {
+        av_dict_set(&mux_options, "movflags", "+empty_moov+default_base_moof+frag_custom", 0);
+        std::cout << "[Mux Info] 低延迟模式：分片MP4，每个Packet写出后立即刷新\n";
+    }
+    ret = avformat_write_header(out_fmt_ctx, &mux_options);
+    av_dict_free(&mux_options);
     if (ret < 0) {
         char err_buf[1024];
         av_strerror(ret, err_buf, sizeof(err_buf));
@@ -94,11 +102,13 @@ void mux_thread(const std::string& output_file,
 
     AVPacket pkt;
     int packet_count = 0;
+    int64_t last_dts = AV_NOPTS_VALUE;
+    bool dts_warned = false;
 
     // 循环读取视频包
     while (true) {
         // 从队列获取packet
-        bool success = g_en_video_pkt_queue.pop(pkt);
+        bool success = video_pkt_queue->pop(pkt);
 
         if (!success) {
             std::cout << "[Mux] 视频包队列已空，停止接收\n";
@@ -109,19 +119,46 @@ void mux_thread(const std::string& output_file,
 
         // 设置流索引
         pkt.stream_index = video_stream->index;
+        int64_t enc_pts = pkt.pts;  // 编码器时间基，延迟统计按它对应
+
+        // 时间基转换：从packet的时间基（编码器输出）到视频流时间基（写头后由容器确定，
+        // 可能与编码器时间基不同）；pts/dts/duration分别换算，B帧的重排关系保持不变
+        av_packet_rescale_ts(&pkt, video_pkt_time_base, video_stream->time_base);
+
+        // dts必须严格递增：流时间基比编码器粗时相邻dts可能换算到同一刻度，顺延一格
+        if (pkt.dts != AV_NOPTS_VALUE && last_dts != AV_NOPTS_VALUE && pkt.dts <= last_dts) {
+            if (!dts_warned) {
+                std::cerr << "[Mux Warn] 视频包dts非递增（" << pkt.dts << " <= " << last_dts << "），顺延处理\n";
+                dts_warned = true;
+            }
+            pkt.dts = last_dts + 1;
+            if (pkt.pts != AV_NOPTS_VALUE && pkt.pts < pkt.dts) {
+                pkt.pts = pkt.dts;
+            }
+        }
+        if (pkt.dts != AV_NOPTS_VALUE) {
+            last_dts = pkt.dts;
+        }
 
-        // 时间基转换：从packet的时间基到视频流时间基
-        // 假设pkt的时间基是1/25（来自编码器输出）
-        av_packet_rescale_ts(&pkt, (AVRational){1, 25}, video_stream->time_base);
-
-        // 写入数据包
-        ret = av_interleaved_write_frame(out_fmt_ctx, &pkt);
+        // 写入数据包（低延迟模式只有一路视频，不需要交织缓冲）
+        ret = opts.low_latency ? av_write_frame(out_fmt_ctx, &pkt) : av_interleaved_write_frame(out_fmt_ctx, &pkt);
         if (ret < 0) {
             char err_buf[1024];
             av_strerror(ret, err_buf, sizeof(err_buf));
             std::cerr << "[Mux Error] 写入视频包失败: " << err_buf
-                      << " (pts=" << pkt.pts << ", size=" << pkt.size
+                      << " (pts=" << pkt.pts << ", dts=" << pkt.dts << ", size=" << pkt.size
                       << ")\n";
+        } else {
+            if (opts.low_latency) {
+                // 空Packet让mov立即把这一帧写成一个fragment（否则要等下一帧到来才知道时长），再刷到文件
+                av_write_frame(out_fmt_ctx, nullptr);
+                if (out_fmt_ctx->pb) {
+                    avio_flush(out_fmt_ctx->pb);
+                }
+            }
+            if (opts.latency) {
+                opts.latency->on_write(enc_pts);
+            }
         }
 
         // 每10个包输出一次信息
@@ -0,0 +1,345 @@
+//
+// Created by Jianing on 2026/01/28.
+//
+#include "parallel_encoder.h"
+#include "pixfmt_convert.h"
+#include "job_stats.h"
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <functional>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavutil/pixdesc.h>
+}
+
+namespace {
+
+// 一段连续的封闭GOP（通常就是一个GOP）：各GOP首帧已标记为I帧，帧的所有权随任务转移
+struct GopJob {
+    int64_t index = 0;
+    std::vector<AVFrame*> frames;
+};
+
+// 编码器重开一次至少覆盖的帧数：有延迟且不支持冲刷复用的编码器按此把多个GOP合成一个任务
+constexpr int kMinFramesPerReopen = 250;
+
+// GOP任务队列 + 按GOP序号的重排缓冲 + 在途GOP上限
+class GopScheduler {
+public:
+    GopScheduler(int max_inflight, DeepCopyPacketQueue* out) : max_inflight(max_inflight), out(out) {}
+
+    // 切分线程提交一个GOP，在途GOP达到上限时阻塞（限制被引用的帧数）
+    void submit(GopJob job) {
+        std::unique_lock<std::mutex> lock(mtx);
+        not_full.wait(lock, [&]() { return inflight < max_inflight; });
+        inflight++;
+        jobs.push_back(std::move(job));
+        has_job.notify_one();
+    }
+
+    // 不再有新GOP
+    void close() {
+        std::lock_guard<std::mutex> lock(mtx);
+        closed = true;
+        has_job.notify_all();
+    }
+
+    // 编码线程取下一个GOP，关闭且取完后返回false
+    bool take(GopJob* job) {
+        std::unique_lock<std::mutex> lock(mtx);
+        has_job.wait(lock, [&]() { return !jobs.empty() || closed; });
+        if (jobs.empty()) {
+            return false;
+        }
+        *job = std::move(jobs.front());
+        jobs.pop_front();
+        return true;
+    }
+
+    // 某GOP编码完成：先放入重排缓冲，再把从next_index起连续完成的GOP按序推入输出队列
+    void complete(int64_t index, std::vector<AVPacket*> packets) {
+        std::lock_guard<std::mutex> lock(mtx);
+        done[index] = std::move(packets);
+        max_waiting = std::max(max_waiting, static_cast<int>(done.size()) - 1);
+        for (auto it = done.find(next_index); it != done.end(); it = done.find(next_index)) {
+            for (AVPacket*& pkt : it->second) {
+                out->push(*pkt);
+                av_packet_free(&pkt);
+            }
+            done.erase(it);
+            next_index++;
+            inflight--;
+        }
+        not_full.notify_one();
+    }
+
+    int max_reorder_wait() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return max_waiting;
+    }
+
+private:
+    const int max_inflight;
+    DeepCopyPacketQueue* out;
+    std::mutex mtx;
+    std::condition_variable not_full, has_job;
+    std::deque<GopJob> jobs;
+    std::map<int64_t, std::vector<AVPacket*>> done;
+    int64_t next_index = 0;
+    int inflight = 0;
+    int max_waiting = 0;  // 已完成但在等前面GOP的最大个数（衡量GOP间耗时不均）
+    bool closed = false;
+};
+
+// 取出编码器当前可输出的全部packet
+void receive_packets(AVCodecContext* enc_ctx, AVRational output_time_base, std::vector<AVPacket*>* packets) {
+    while (true) {
+        AVPacket* pkt = av_packet_alloc();
+        int ret = pkt ? avcodec_receive_packet(enc_ctx, pkt) : AVERROR(ENOMEM);
+        if (ret < 0) {
+            av_packet_free(&pkt);
+            if (ret != AVERROR(EAGAIN) && ret != AVERROR_EOF) {
+                char err_buf[1024];
+                av_strerror(ret, err_buf, sizeof(err_buf));
+                std::cerr << "[ParallelEncoder Warn] 接收编码包失败：" << err_buf << "\n";
+            }
+            return;
+        }
+        pkt->stream_index = 0;
+        av_packet_rescale_ts(pkt, enc_ctx->time_base, output_time_base);
+        packets->push_back(pkt);
+    }
+}
+
+// 编码器实际是否有输出延迟：送一帧灰帧看能否立即取到包。AV_CODEC_CAP_DELAY只说明可能有延迟，
+// mpeg4等在无B帧时并不缓存帧
+bool encoder_has_delay(const EncoderProfile& profile, int width, int height, AVRational time_base) {
+    AVCodecContext* enc_ctx = open_video_encoder(profile, width, height, time_base);
+    if (!enc_ctx) {
+        return true;
+    }
+    bool delay = true;
+    AVFrame* frame = av_frame_alloc();
+    AVPacket* pkt = av_packet_alloc();
+    if (frame && pkt) {
+        frame->format = AV_PIX_FMT_YUV420P;
+        frame->width = width;
+        frame->height = height;
+        frame->pts = 0;
+        if (av_frame_get_buffer(frame, 0) >= 0) {
+            for (int plane = 0; plane < 3; plane++) {
+                int rows = plane == 0 ? height : (height + 1) / 2;
+                std::fill(frame->data[plane], frame->data[plane] + static_cast<size_t>(frame->linesize[plane]) * rows,
+                          static_cast<uint8_t>(128));
+            }
+            if (avcodec_send_frame(enc_ctx, frame) >= 0) {
+                delay = avcodec_receive_packet(enc_ctx, pkt) < 0;
+            }
+        }
+    }
+    av_packet_free(&pkt);
+    av_frame_free(&frame);
+    avcodec_free_context(&enc_ctx);
+    return delay;
+}
+
+// 编码线程：每个实例一个编码器上下文，跨GOP复用。GOP首帧强制I帧、无B帧，
+// 参考关系不会跨越GOP，因此各实例交错处理的GOP拼接后仍是合法码流。
+// 任务结束时编码器里还有未输出的帧才需要冲刷：支持AV_CODEC_CAP_ENCODER_FLUSH的用avcodec_flush_buffers
+// 复位后继续使用，否则只能重开（此时切分线程已把多个GOP合成一个任务，按任务而不是按GOP重开）
+void gop_worker(int id, GopScheduler* sched, int width, int height, AVRational output_time_base,
+                const EncoderProfile& profile) {
+    AVCodecContext* enc_ctx = open_video_encoder(profile, width, height, output_time_base);
+    int64_t job_count = 0;
+    int64_t frame_count = 0;
+    int64_t reopen_count = 0;
+    GopJob job;
+
+    while (sched->take(&job)) {
+        auto start = std::chrono::steady_clock::now();
+        std::vector<AVPacket*> packets;
+        int64_t sent = 0;
+        for (AVFrame* frame : job.frames) {
+            if (enc_ctx) {
+                int ret = avcodec_send_frame(enc_ctx, frame);
+                if (ret < 0) {
+                    char err_buf[1024];
+                    av_strerror(ret, err_buf, sizeof(err_buf));
+                    std::cerr << "[ParallelEncoder Warn] 编码器" << id << " 发送帧失败（任务 " << job.index
+                              << "）：" << err_buf << "\n";
+                } else {
+                    sent++;
+                    receive_packets(enc_ctx, output_time_base, &packets);
+                }
+            }
+            av_frame_free(&frame);
+        }
+
+        // 还有帧留在编码器里：冲刷出来，保证本任务的包全部在本任务内输出
+        if (enc_ctx && static_cast<int64_t>(packets.size()) < sent) {
+            if (avcodec_send_frame(enc_ctx, nullptr) >= 0) {
+                receive_packets(enc_ctx, output_time_base, &packets);
+            }
+            if (enc_ctx->codec->capabilities & AV_CODEC_CAP_ENCODER_FLUSH) {
+                avcodec_flush_buffers(enc_ctx);
+            } else {
+                avcodec_free_context(&enc_ctx);
+                enc_ctx = open_video_encoder(profile, width, height, output_time_base);
+                reopen_count++;
+            }
+        }
+
+        job_count++;
+        frame_count += static_cast<int64_t>(job.frames.size());
+        g_job_stats.add_time("encode.gop", std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(),
+                             static_cast<int64_t>(job.frames.size()));
+        // 编码失败也要提交（空包列表），否则重排缓冲会一直等这个GOP
+        sched->complete(job.index, std::move(packets));
+        job = GopJob();
+    }
+
+    avcodec_free_context(&enc_ctx);
+    std::cout << "[ParallelEncoder Info] 编码器" << id << " 退出：" << job_count << " 个任务，" << frame_count
+              << " 帧，重开编码器 " << reopen_count << " 次\n";
+}
+
+} // namespace
+
+void parallel_encode_thread(AVCodecParameters* src_codec_par, AVRational output_time_base,
+                            ParallelEncodeOptions opts) {
+    if (!src_codec_par) {
+        std::cerr << "[ParallelEncoder Error] 输入编码器参数为空指针！\n";
+        opts.encode.out_queue->mark_done();
+        return;
+    }
+    const VideoEncodeOptions& enc = opts.encode;
+    const int workers = std::max(opts.workers, 1);
+    const int max_inflight = opts.max_inflight_gops > 0 ? opts.max_inflight_gops : 2 * workers;
+    const int gop_size = std::max(enc.profile.gop_size, 1);
+    const int max_gop = enc.scene_cut.enabled ? std::max(enc.scene_cut.max_gop, 1) : gop_size;
+    if (enc.quality.enabled || enc.dedup.enabled) {
+        std::cerr << "[ParallelEncoder Warn] 并行GOP模式不支持质量评估/重复帧消除，已忽略\n";
+    }
+
+    // 各实例：编码器自身的GOP设为最长GOP，关键帧只出现在切分线程标记的位置；
+    // 并行度来自多个实例，每个实例单线程；封闭GOP不能有B帧
+    EncoderProfile profile = enc.profile;
+    if (profile.color_range == AVCOL_RANGE_UNSPECIFIED) {
+        profile.color_range = yuv420p_color_range(static_cast<AVPixelFormat>(src_codec_par->format),
+                                                  src_codec_par->color_range);
+    }
+    profile.gop_size = max_gop;
+    profile.threads = 1;
+    profile.max_b_frames = 0;
+
+    // 有延迟又不能冲刷复用的编码器每个任务结束都要重开：把多个GOP合成一个任务，摊薄重开开销
+    int gops_per_job = 1;
+    if (encoder_has_delay(profile, src_codec_par->width, src_codec_par->height, output_time_base)) {
+        const AVCodec* codec = avcodec_find_encoder_by_name(profile.codec.c_str());
+        if (codec && !(codec->capabilities & AV_CODEC_CAP_ENCODER_FLUSH)) {
+            gops_per_job = std::max(1, (kMinFramesPerReopen + gop_size - 1) / gop_size);
+            std::cout << "[ParallelEncoder Info] " << profile.codec << " 有编码延迟且不支持冲刷复用，每 "
+                      << gops_per_job << " 个GOP一个任务\n";
+        }
+    }
+
+    // 【一次性信息】保留
+    std::cout << "[ParallelEncoder Info] 并行GOP编码：" << workers << " 个" << profile.codec << "编码器实例（配置 "
+              << profile.name << "），"
+              << (enc.scene_cut.enabled ? "按场景切换切分GOP（最长" : "固定GOP（")
+              << max_gop << "帧），在途GOP上限 " << max_inflight << "\n";
+
+    GopScheduler sched(max_inflight, enc.out_queue);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < workers; i++) {
+        threads.emplace_back(gop_worker, i, &sched, src_codec_par->width, src_codec_par->height,
+                             output_time_base, std::cref(profile));
+    }
+
+    SceneCutDetector scene_detector(enc.scene_cut);
+    FramePool conv_pool;
+    bool conv_logged = false;
+    AVFrame* frame = av_frame_alloc();
+    GopJob job;
+    int64_t frame_count = 0;
+    int64_t gop_count = 0;
+    int64_t job_count = 0;
+    int job_gops = 0;   // 当前任务已有的GOP数
+    int gop_frames = 0; // 当前GOP已有的帧数
+
+    while (frame && enc.in_ringbuf->pop(frame)) {
+        if (!frame->data[0]) {
+            av_frame_unref(frame);
+            continue;
+        }
+        if (enc.latency) {
+            enc.latency->on_excluded();  // 各GOP并行编码，送编码/编码输出时间戳没有逐帧对应关系
+        }
+
+        // 帧的所有权交给GOP任务：非YUV420P先转换，否则直接转移引用
+        AVFrame* owned = av_frame_alloc();
+        if (!owned) {
+            av_frame_unref(frame);
+            continue;
+        }
+        AVPixelFormat src_fmt = static_cast<AVPixelFormat>(frame->format);
+        if (src_fmt != AV_PIX_FMT_YUV420P && can_convert_to_yuv420p(src_fmt)) {
+            int ret = convert_to_yuv420p(frame, owned, &conv_pool);
+            av_frame_unref(frame);
+            if (ret < 0) {
+                av_frame_free(&owned);
+                continue;
+            }
+            if (!conv_logged) {
+                std::cout << "[ParallelEncoder Info] 输入像素格式 " << av_get_pix_fmt_name(src_fmt)
+                          << "，转换为 yuv420p 后编码\n";
+                conv_logged = true;
+            }
+        } else {
+            av_frame_move_ref(owned, frame);
+        }
+        owned->pts = frame_count++;
+
+        // GOP边界：场景切换（检测器已包含最长GOP）或固定GOP长度
+        bool boundary = enc.scene_cut.enabled ? scene_detector.next_keyframe(owned) : gop_frames >= gop_size;
+        if (boundary || gop_count == 0) {
+            boundary = true;
+            if (job_gops >= gops_per_job) {
+                job.index = job_count++;
+                sched.submit(std::move(job));
+                job = GopJob();
+                job_gops = 0;
+            }
+            job_gops++;
+            gop_count++;
+            gop_frames = 0;
+        }
+        owned->pict_type = boundary ? AV_PICTURE_TYPE_I : AV_PICTURE_TYPE_NONE;
+        gop_frames++;
+        job.frames.push_back(owned);
+    }
+    if (!job.frames.empty()) {
+        job.index = job_count++;
+        sched.submit(std::move(job));
+    }
+    sched.close();
+
+    for (auto& t : threads) {
+        t.join();
+    }
+    enc.out_queue->mark_done();
+    av_frame_free(&frame);
+
+    g_job_stats.add_count("encode.parallel_gops", gop_count);
+    // 【退出总结】保留输出
+    std::cout << "[ParallelEncoder Info] 并行编码结束：" << frame_count << " 帧，" << gop_count
+              << " 个GOP（" << job_count << " 个任务），重排缓冲最多等待 " << sched.max_reorder_wait() << " 个任务\n";
+}
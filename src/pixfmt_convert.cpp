@@ -0,0 +1,274 @@
+//
+// Created by Jianing on 2026/01/18.
+//
+#include "pixfmt_convert.h"
+#include "pixfmt_kernels.h"
+#include <iostream>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <algorithm>
+
+extern "C" {
+#include <libavutil/imgutils.h>
+#include <libavutil/pixdesc.h>
+#include <libswscale/swscale.h>
+}
+
+namespace {
+
+// 用指定内核转换，dst缓冲已分配好
+void convert_planes(const PixFmtKernels& k, const AVFrame* src, AVFrame* dst) {
+    const int w = src->width;
+    const int h = src->height;
+    const int cw = (w + 1) >> 1;
+    const int ch = (h + 1) >> 1;
+
+    switch (src->format) {
+        case AV_PIX_FMT_NV12:
+            av_image_copy_plane(dst->data[0], dst->linesize[0], src->data[0], src->linesize[0], w, h);
+            for (int y = 0; y < ch; y++) {
+                k.deinterleave_uv(src->data[1] + y * src->linesize[1],
+                                  dst->data[1] + y * dst->linesize[1],
+                                  dst->data[2] + y * dst->linesize[2], cw);
+            }
+            break;
+
+        case AV_PIX_FMT_YUV422P:
+        case AV_PIX_FMT_YUVJ422P:
+            av_image_copy_plane(dst->data[0], dst->linesize[0], src->data[0], src->linesize[0], w, h);
+            for (int p = 1; p <= 2; p++) {
+                for (int y = 0; y < ch; y++) {
+                    // 奇数高度时最后一行与自身平均（即直接复制）
+                    int y1 = std::min(2 * y + 1, h - 1);
+                    k.average_rows(src->data[p] + 2 * y * src->linesize[p],
+                                   src->data[p] + y1 * src->linesize[p],
+                                   dst->data[p] + y * dst->linesize[p], cw);
+                }
+            }
+            break;
+
+        case AV_PIX_FMT_YUYV422:
+            for (int y = 0; y < ch; y++) {
+                int y1 = std::min(2 * y + 1, h - 1);
+                k.yuyv_to_yuv420(src->data[0] + 2 * y * src->linesize[0],
+                                 src->data[0] + y1 * src->linesize[0],
+                                 dst->data[0] + 2 * y * dst->linesize[0],
+                                 dst->data[0] + y1 * dst->linesize[0],
+                                 dst->data[1] + y * dst->linesize[1],
+                                 dst->data[2] + y * dst->linesize[2], w);
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+int alloc_yuv420p(const AVFrame* src, AVFrame* dst, FramePool* pool) {
+    dst->format = AV_PIX_FMT_YUV420P;
+    dst->width = src->width;
+    dst->height = src->height;
+    int ret = pool ? pool->get_buffer(dst) : av_frame_get_buffer(dst, 0);
+    if (ret < 0) {
+        return ret;
+    }
+    av_frame_copy_props(dst, src);
+    return 0;
+}
+
+bool is_full_range(AVPixelFormat fmt) {
+    return fmt == AV_PIX_FMT_YUVJ420P || fmt == AV_PIX_FMT_YUVJ422P;
+}
+
+std::vector<uint8_t> random_bytes(std::mt19937& rng, size_t n) {
+    std::vector<uint8_t> buf(n);
+    for (auto& b : buf) {
+        b = static_cast<uint8_t>(rng());
+    }
+    return buf;
+}
+
+} // namespace
+
+bool can_convert_to_yuv420p(AVPixelFormat fmt) {
+    switch (fmt) {
+        case AV_PIX_FMT_NV12:
+        case AV_PIX_FMT_YUV422P:
+        case AV_PIX_FMT_YUVJ422P:
+        case AV_PIX_FMT_YUYV422:
+        case AV_PIX_FMT_YUVJ420P:
+            return true;
+        default:
+            return false;
+    }
+}
+
+AVColorRange yuv420p_color_range(AVPixelFormat fmt, AVColorRange range) {
+    if (is_full_range(fmt) || range == AVCOL_RANGE_JPEG) {
+        return AVCOL_RANGE_JPEG;
+    }
+    return range;
+}
+
+int convert_to_yuv420p(const AVFrame* src, AVFrame* dst, FramePool* pool) {
+    AVPixelFormat fmt = static_cast<AVPixelFormat>(src->format);
+    if (!can_convert_to_yuv420p(fmt)) {
+        return AVERROR(ENOSYS);
+    }
+
+    if (fmt == AV_PIX_FMT_YUVJ420P) {
+        // 内存布局相同，只有取值范围不同：改标记即可
+        int ret = av_frame_ref(dst, src);
+        if (ret < 0) {
+            return ret;
+        }
+        dst->format = AV_PIX_FMT_YUV420P;
+        dst->color_range = AVCOL_RANGE_JPEG;
+        return 0;
+    }
+
+    int ret = alloc_yuv420p(src, dst, pool);
+    if (ret < 0) {
+        return ret;
+    }
+    convert_planes(pixfmt_kernels(), src, dst);
+    if (is_full_range(fmt)) {
+        dst->color_range = AVCOL_RANGE_JPEG;
+    }
+    return 0;
+}
+
+bool pixfmt_kernels_self_check() {
+    std::vector<const PixFmtKernels*> kernels = pixfmt_kernels_available();
+    const PixFmtKernels& ref = *kernels.front();
+    std::mt19937 rng(20260118);
+    // 覆盖各向量宽度的整倍数及其±1，检验尾部处理
+    const int lengths[] = {1, 2, 3, 15, 16, 17, 31, 32, 33, 63, 64, 65, 127, 129, 960, 1921, 4113};
+    bool ok = true;
+
+    for (size_t i = 1; i < kernels.size(); i++) {
+        const PixFmtKernels& k = *kernels[i];
+        for (int n : lengths) {
+            std::vector<uint8_t> uv = random_bytes(rng, 2 * n);
+            std::vector<uint8_t> a = random_bytes(rng, n);
+            std::vector<uint8_t> b = random_bytes(rng, n);
+            std::vector<uint8_t> yuyv0 = random_bytes(rng, 4 * ((n + 1) / 2));
+            std::vector<uint8_t> yuyv1 = random_bytes(rng, 4 * ((n + 1) / 2));
+            int cn = (n + 1) / 2;
+
+            std::vector<uint8_t> ru(n), rv(n), tu(n), tv(n);
+            ref.deinterleave_uv(uv.data(), ru.data(), rv.data(), n);
+            k.deinterleave_uv(uv.data(), tu.data(), tv.data(), n);
+            bool same = ru == tu && rv == tv;
+
+            std::vector<uint8_t> ravg(n), tavg(n);
+            ref.average_rows(a.data(), b.data(), ravg.data(), n);
+            k.average_rows(a.data(), b.data(), tavg.data(), n);
+            same = same && ravg == tavg;
+
+            std::vector<uint8_t> ry0(n), ry1(n), rcu(cn), rcv(cn);
+            std::vector<uint8_t> ty0(n), ty1(n), tcu(cn), tcv(cn);
+            ref.yuyv_to_yuv420(yuyv0.data(), yuyv1.data(), ry0.data(), ry1.data(), rcu.data(), rcv.data(), n);
+            k.yuyv_to_yuv420(yuyv0.data(), yuyv1.data(), ty0.data(), ty1.data(), tcu.data(), tcv.data(), n);
+            same = same && ry0 == ty0 && ry1 == ty1 && rcu == tcu && rcv == tcv;
+
+            // 盒式缩小：输出n个像素，分别读取2行x2n / 4行x4n个源像素
+            std::vector<uint8_t> rows = random_bytes(rng, 16 * n);
+            const uint8_t* r = rows.data();
+            std::vector<uint8_t> rbox(n), tbox(n);
+            ref.box2_row(r, r + 4 * n, rbox.data(), n);
+            k.box2_row(r, r + 4 * n, tbox.data(), n);
+            same = same && rbox == tbox;
+            ref.box4_row(r, r + 4 * n, r + 8 * n, r + 12 * n, rbox.data(), n);
+            k.box4_row(r, r + 4 * n, r + 8 * n, r + 12 * n, tbox.data(), n);
+            same = same && rbox == tbox;
+
+            same = same && ref.sad_row(a.data(), b.data(), n) == k.sad_row(a.data(), b.data(), n);
+            same = same && ref.sse_row(a.data(), b.data(), n) == k.sse_row(a.data(), b.data(), n);
+
+            // SSIM统计：把rows看作4行x4n的两幅图（步长不同），求n个4x4块
+            std::vector<int32_t> rsums(4 * n), tsums(4 * n);
+            ref.ssim_4x4_row(r, 4 * n, r + 1, 3 * n, reinterpret_cast<int32_t(*)[4]>(rsums.data()), n);
+            k.ssim_4x4_row(r, 4 * n, r + 1, 3 * n, reinterpret_cast<int32_t(*)[4]>(tsums.data()), n);
+            same = same && rsums == tsums;
+
+            std::vector<uint32_t> racc(n, 7), tacc(n, 7);
+            ref.accumulate_row(a.data(), racc.data(), n);
+            k.accumulate_row(a.data(), tacc.data(), n);
+            same = same && racc == tacc;
+
+            if (!same) {
+                std::cerr << "[PixFmt Error] " << k.name << " 内核与C实现不一致（长度" << n << "）\n";
+                ok = false;
+            }
+        }
+    }
+
+    std::cout << "[PixFmt Info] 内核一致性校验" << (ok ? "通过" : "失败") << "（";
+    for (size_t i = 0; i < kernels.size(); i++) {
+        std::cout << (i ? "/" : "") << kernels[i]->name;
+    }
+    std::cout << "）\n";
+    return ok;
+}
+
+void pixfmt_benchmark(int width, int height, int iterations) {
+    const AVPixelFormat formats[] = {AV_PIX_FMT_NV12, AV_PIX_FMT_YUV422P, AV_PIX_FMT_YUYV422};
+    std::vector<const PixFmtKernels*> kernels = pixfmt_kernels_available();
+    std::mt19937 rng(1);
+
+    AVFrame* src = av_frame_alloc();
+    AVFrame* dst = av_frame_alloc();
+    dst->format = AV_PIX_FMT_YUV420P;
+    dst->width = width;
+    dst->height = height;
+    if (!src || !dst || av_frame_get_buffer(dst, 0) < 0) {
+        av_frame_free(&src);
+        av_frame_free(&dst);
+        return;
+    }
+
+    for (AVPixelFormat fmt : formats) {
+        av_frame_unref(src);
+        src->format = fmt;
+        src->width = width;
+        src->height = height;
+        if (av_frame_get_buffer(src, 0) < 0) {
+            break;
+        }
+        for (int p = 0; p < 4 && src->buf[p]; p++) {
+            std::vector<uint8_t> noise = random_bytes(rng, src->buf[p]->size);
+            std::copy(noise.begin(), noise.end(), src->buf[p]->data);
+        }
+        // 吞吐按源帧字节数计算
+        double frame_bytes = av_image_get_buffer_size(fmt, width, height, 1);
+
+        auto report = [&](const char* name, double seconds) {
+            std::cout << "[PixFmt Bench] " << av_get_pix_fmt_name(fmt) << " → yuv420p " << name << ": "
+                      << (seconds > 0 ? frame_bytes * iterations / seconds / 1e9 : 0.0) << " GB/s\n";
+        };
+
+        for (const PixFmtKernels* k : kernels) {
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < iterations; i++) {
+                convert_planes(*k, src, dst);
+            }
+            report(k->name, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        }
+
+        SwsContext* sws = sws_getContext(width, height, fmt, width, height, AV_PIX_FMT_YUV420P,
+                                         SWS_POINT, nullptr, nullptr, nullptr);
+        if (sws) {
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < iterations; i++) {
+                sws_scale(sws, src->data, src->linesize, 0, height, dst->data, dst->linesize);
+            }
+            report("swscale", std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+            sws_freeContext(sws);
+        }
+    }
+
+    av_frame_free(&src);
+    av_frame_free(&dst);
+}
@@ -0,0 +1,680 @@
+//
+// Created by Jianing on 2026/01/18.
+//
+#include "pixfmt_kernels.h"
+#include "simd.h"
+#include <algorithm>
+
+extern "C" {
+#include <libavutil/cpu.h>
+}
+
+namespace {
+
+// ====================== C参考实现 ======================
+
+void deinterleave_uv_c(const uint8_t* uv, uint8_t* u, uint8_t* v, int n) {
+    for (int i = 0; i < n; i++) {
+        u[i] = uv[2 * i];
+        v[i] = uv[2 * i + 1];
+    }
+}
+
+void average_rows_c(const uint8_t* a, const uint8_t* b, uint8_t* dst, int n) {
+    for (int i = 0; i < n; i++) {
+        dst[i] = static_cast<uint8_t>((a[i] + b[i] + 1) >> 1);
+    }
+}
+
+// 从第x个像素（偶数）开始处理剩余像素，SIMD版本用它收尾
+void yuyv_to_yuv420_tail(const uint8_t* row0, const uint8_t* row1,
+                         uint8_t* y0, uint8_t* y1, uint8_t* u, uint8_t* v, int x, int width) {
+    for (; x + 1 < width; x += 2) {
+        const uint8_t* p0 = row0 + 2 * x;
+        const uint8_t* p1 = row1 + 2 * x;
+        y0[x] = p0[0];
+        y0[x + 1] = p0[2];
+        y1[x] = p1[0];
+        y1[x + 1] = p1[2];
+        u[x / 2] = static_cast<uint8_t>((p0[1] + p1[1] + 1) >> 1);
+        v[x / 2] = static_cast<uint8_t>((p0[3] + p1[3] + 1) >> 1);
+    }
+    if (x < width) {
+        // 奇数宽度：最后一个像素仍占半个宏像素，色度照常取
+        const uint8_t* p0 = row0 + 2 * x;
+        const uint8_t* p1 = row1 + 2 * x;
+        y0[x] = p0[0];
+        y1[x] = p1[0];
+        u[x / 2] = static_cast<uint8_t>((p0[1] + p1[1] + 1) >> 1);
+        v[x / 2] = static_cast<uint8_t>((p0[3] + p1[3] + 1) >> 1);
+    }
+}
+
+void yuyv_to_yuv420_c(const uint8_t* row0, const uint8_t* row1,
+                      uint8_t* y0, uint8_t* y1, uint8_t* u, uint8_t* v, int width) {
+    yuyv_to_yuv420_tail(row0, row1, y0, y1, u, v, 0, width);
+}
+
+void box2_row_c(const uint8_t* r0, const uint8_t* r1, uint8_t* dst, int dst_w) {
+    for (int x = 0; x < dst_w; x++) {
+        dst[x] = static_cast<uint8_t>((r0[2 * x] + r0[2 * x + 1] + r1[2 * x] + r1[2 * x + 1] + 2) >> 2);
+    }
+}
+
+void box4_row_c(const uint8_t* r0, const uint8_t* r1, const uint8_t* r2, const uint8_t* r3,
+                uint8_t* dst, int dst_w) {
+    for (int x = 0; x < dst_w; x++) {
+        int sum = 0;
+        for (int i = 0; i < 4; i++) {
+            sum += r0[4 * x + i] + r1[4 * x + i] + r2[4 * x + i] + r3[4 * x + i];
+        }
+        dst[x] = static_cast<uint8_t>((sum + 8) >> 4);
+    }
+}
+
+uint32_t sad_row_c(const uint8_t* a, const uint8_t* b, int n) {
+    uint32_t sum = 0;
+    for (int i = 0; i < n; i++) {
+        sum += static_cast<uint32_t>(a[i] > b[i] ? a[i] - b[i] : b[i] - a[i]);
+    }
+    return sum;
+}
+
+uint64_t sse_row_c(const uint8_t* a, const uint8_t* b, int n) {
+    uint64_t sum = 0;
+    for (int i = 0; i < n; i++) {
+        int d = a[i] - b[i];
+        sum += static_cast<uint64_t>(d * d);
+    }
+    return sum;
+}
+
+void ssim_4x4_row_c(const uint8_t* a, ptrdiff_t a_stride, const uint8_t* b, ptrdiff_t b_stride,
+                    int32_t (*sums)[4], int blocks) {
+    for (int z = 0; z < blocks; z++) {
+        int32_t s1 = 0, s2 = 0, ss = 0, s12 = 0;
+        for (int y = 0; y < 4; y++) {
+            for (int x = 0; x < 4; x++) {
+                int ia = a[4 * z + x + y * a_stride];
+                int ib = b[4 * z + x + y * b_stride];
+                s1 += ia;
+                s2 += ib;
+                ss += ia * ia + ib * ib;
+                s12 += ia * ib;
+            }
+        }
+        sums[z][0] = s1;
+        sums[z][1] = s2;
+        sums[z][2] = ss;
+        sums[z][3] = s12;
+    }
+}
+
+void accumulate_row_c(const uint8_t* row, uint32_t* acc, int n) {
+    for (int i = 0; i < n; i++) {
+        acc[i] += row[i];
+    }
+}
+
+// 平方和按块在32位中累加，每块最多这么多字节后并入64位累加器（每字节最多255²，不会溢出）
+constexpr int kSseChunk = 4096;
+
+const PixFmtKernels kKernelsC = {"c", deinterleave_uv_c, average_rows_c, yuyv_to_yuv420_c,
+                                 box2_row_c, box4_row_c, sad_row_c, sse_row_c, ssim_4x4_row_c,
+                                 accumulate_row_c};
+
+#if SIMD_X86
+// ====================== SSE4 ======================
+
+SIMD_TARGET_SSE4
+void deinterleave_uv_sse4(const uint8_t* uv, uint8_t* u, uint8_t* v, int n) {
+    const __m128i shuf = _mm_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15);
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i a = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(uv + 2 * i)), shuf);
+        __m128i b = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(uv + 2 * i + 16)), shuf);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(u + i), _mm_unpacklo_epi64(a, b));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(v + i), _mm_unpackhi_epi64(a, b));
+    }
+    deinterleave_uv_c(uv + 2 * i, u + i, v + i, n - i);
+}
+
+SIMD_TARGET_SSE4
+void average_rows_sse4(const uint8_t* a, const uint8_t* b, uint8_t* dst, int n) {
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+        __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_avg_epu8(x, y));
+    }
+    average_rows_c(a + i, b + i, dst + i, n - i);
+}
+
+SIMD_TARGET_SSE4
+void yuyv_to_yuv420_sse4(const uint8_t* row0, const uint8_t* row1,
+                         uint8_t* y0, uint8_t* y1, uint8_t* u, uint8_t* v, int width) {
+    const __m128i mask = _mm_set1_epi16(0x00ff);
+    const __m128i shuf = _mm_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15);
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        __m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + 2 * x));
+        __m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + 2 * x + 16));
+        __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + 2 * x));
+        __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + 2 * x + 16));
+
+        // 偶数字节为Y，奇数字节为交错的U/V
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(y0 + x),
+                         _mm_packus_epi16(_mm_and_si128(a0, mask), _mm_and_si128(a1, mask)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(y1 + x),
+                         _mm_packus_epi16(_mm_and_si128(b0, mask), _mm_and_si128(b1, mask)));
+
+        __m128i ca = _mm_packus_epi16(_mm_srli_epi16(a0, 8), _mm_srli_epi16(a1, 8));
+        __m128i cb = _mm_packus_epi16(_mm_srli_epi16(b0, 8), _mm_srli_epi16(b1, 8));
+        __m128i c = _mm_shuffle_epi8(_mm_avg_epu8(ca, cb), shuf);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(u + x / 2), c);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(v + x / 2), _mm_srli_si128(c, 8));
+    }
+    yuyv_to_yuv420_tail(row0, row1, y0, y1, u, v, x, width);
+}
+
+// 横向相邻两像素求和（16位），maddubs与全1相乘即两两相加
+SIMD_TARGET_SSE4
+inline __m128i pair_sums_sse4(const uint8_t* p) {
+    return _mm_maddubs_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)), _mm_set1_epi8(1));
+}
+
+SIMD_TARGET_SSE4
+void box2_row_sse4(const uint8_t* r0, const uint8_t* r1, uint8_t* dst, int dst_w) {
+    const __m128i two = _mm_set1_epi16(2);
+    int x = 0;
+    for (; x + 16 <= dst_w; x += 16) {
+        __m128i lo = _mm_add_epi16(pair_sums_sse4(r0 + 2 * x), pair_sums_sse4(r1 + 2 * x));
+        __m128i hi = _mm_add_epi16(pair_sums_sse4(r0 + 2 * x + 16), pair_sums_sse4(r1 + 2 * x + 16));
+        lo = _mm_srli_epi16(_mm_add_epi16(lo, two), 2);
+        hi = _mm_srli_epi16(_mm_add_epi16(hi, two), 2);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), _mm_packus_epi16(lo, hi));
+    }
+    box2_row_c(r0 + 2 * x, r1 + 2 * x, dst + x, dst_w - x);
+}
+
+SIMD_TARGET_SSE4
+void box4_row_sse4(const uint8_t* r0, const uint8_t* r1, const uint8_t* r2, const uint8_t* r3,
+                   uint8_t* dst, int dst_w) {
+    const __m128i ones = _mm_set1_epi16(1);
+    const __m128i eight = _mm_set1_epi32(8);
+    int x = 0;
+    for (; x + 8 <= dst_w; x += 8) {
+        __m128i q[2];
+        for (int k = 0; k < 2; k++) {
+            int off = 4 * x + 16 * k;
+            // 四行的两两和相加（最大2040，16位不溢出），再横向两两相加成4x4块和（32位）
+            __m128i s = _mm_add_epi16(_mm_add_epi16(pair_sums_sse4(r0 + off), pair_sums_sse4(r1 + off)),
+                                      _mm_add_epi16(pair_sums_sse4(r2 + off), pair_sums_sse4(r3 + off)));
+            q[k] = _mm_srli_epi32(_mm_add_epi32(_mm_madd_epi16(s, ones), eight), 4);
+        }
+        __m128i w = _mm_packs_epi32(q[0], q[1]);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + x), _mm_packus_epi16(w, w));
+    }
+    box4_row_c(r0 + 4 * x, r1 + 4 * x, r2 + 4 * x, r3 + 4 * x, dst + x, dst_w - x);
+}
+
+SIMD_TARGET_SSE4
+uint32_t sad_row_sse4(const uint8_t* a, const uint8_t* b, int n) {
+    __m128i acc = _mm_setzero_si128();
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        // psadbw：每8字节的绝对差之和放在对应64位中
+        acc = _mm_add_epi64(acc, _mm_sad_epu8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i)),
+                                              _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i))));
+    }
+    uint32_t sum = static_cast<uint32_t>(_mm_cvtsi128_si32(acc) + _mm_extract_epi32(acc, 2));
+    return sum + sad_row_c(a + i, b + i, n - i);
+}
+
+SIMD_TARGET_SSE4
+uint64_t sse_row_sse4(const uint8_t* a, const uint8_t* b, int n) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i acc64 = zero;
+    int i = 0;
+    while (i + 16 <= n) {
+        __m128i acc = zero;
+        int end = std::min(n, i + kSseChunk);
+        for (; i + 16 <= end; i += 16) {
+            __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+            __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+            __m128i dlo = _mm_sub_epi16(_mm_cvtepu8_epi16(va), _mm_cvtepu8_epi16(vb));
+            __m128i dhi = _mm_sub_epi16(_mm_unpackhi_epi8(va, zero), _mm_unpackhi_epi8(vb, zero));
+            // pmaddwd：相邻两个差的平方和
+            acc = _mm_add_epi32(acc, _mm_add_epi32(_mm_madd_epi16(dlo, dlo), _mm_madd_epi16(dhi, dhi)));
+        }
+        acc64 = _mm_add_epi64(acc64, _mm_add_epi64(_mm_cvtepu32_epi64(acc), _mm_unpackhi_epi32(acc, zero)));
+    }
+    uint64_t lanes[2];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), acc64);
+    return lanes[0] + lanes[1] + sse_row_c(a + i, b + i, n - i);
+}
+
+SIMD_TARGET_SSE4
+void ssim_4x4_row_sse4(const uint8_t* a, ptrdiff_t a_stride, const uint8_t* b, ptrdiff_t b_stride,
+                       int32_t (*sums)[4], int blocks) {
+    const __m128i ones8 = _mm_set1_epi8(1);
+    const __m128i ones16 = _mm_set1_epi16(1);
+    int z = 0;
+    for (; z + 4 <= blocks; z += 4) {
+        // 一次4个块（16列）：像素和用pmaddubsw按像素对累加，平方和/乘积和用pmaddwd
+        __m128i s1 = _mm_setzero_si128(), s2 = _mm_setzero_si128();
+        __m128i ss_lo = _mm_setzero_si128(), ss_hi = _mm_setzero_si128();
+        __m128i s12_lo = _mm_setzero_si128(), s12_hi = _mm_setzero_si128();
+        for (int y = 0; y < 4; y++) {
+            __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + 4 * z + y * a_stride));
+            __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + 4 * z + y * b_stride));
+            s1 = _mm_add_epi16(s1, _mm_maddubs_epi16(va, ones8));
+            s2 = _mm_add_epi16(s2, _mm_maddubs_epi16(vb, ones8));
+            __m128i alo = _mm_cvtepu8_epi16(va), ahi = _mm_cvtepu8_epi16(_mm_srli_si128(va, 8));
+            __m128i blo = _mm_cvtepu8_epi16(vb), bhi = _mm_cvtepu8_epi16(_mm_srli_si128(vb, 8));
+            ss_lo = _mm_add_epi32(ss_lo, _mm_add_epi32(_mm_madd_epi16(alo, alo), _mm_madd_epi16(blo, blo)));
+            ss_hi = _mm_add_epi32(ss_hi, _mm_add_epi32(_mm_madd_epi16(ahi, ahi), _mm_madd_epi16(bhi, bhi)));
+            s12_lo = _mm_add_epi32(s12_lo, _mm_madd_epi16(alo, blo));
+            s12_hi = _mm_add_epi32(s12_hi, _mm_madd_epi16(ahi, bhi));
+        }
+        // 像素对之和 → 每块之和（16位的再用pmaddwd两两相加，32位的用phaddd）
+        __m128i v0 = _mm_madd_epi16(s1, ones16);
+        __m128i v1 = _mm_madd_epi16(s2, ones16);
+        __m128i v2 = _mm_hadd_epi32(ss_lo, ss_hi);
+        __m128i v3 = _mm_hadd_epi32(s12_lo, s12_hi);
+        // 4x4转置为每块一组 {s1, s2, ss, s12}
+        __m128i t0 = _mm_unpacklo_epi32(v0, v1), t1 = _mm_unpacklo_epi32(v2, v3);
+        __m128i t2 = _mm_unpackhi_epi32(v0, v1), t3 = _mm_unpackhi_epi32(v2, v3);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(sums[z]), _mm_unpacklo_epi64(t0, t1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(sums[z + 1]), _mm_unpackhi_epi64(t0, t1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(sums[z + 2]), _mm_unpacklo_epi64(t2, t3));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(sums[z + 3]), _mm_unpackhi_epi64(t2, t3));
+    }
+    ssim_4x4_row_c(a + 4 * z, a_stride, b + 4 * z, b_stride, sums + z, blocks - z);
+}
+
+SIMD_TARGET_SSE4
+void accumulate_row_sse4(const uint8_t* row, uint32_t* acc, int n) {
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i));
+        for (int k = 0; k < 4; k++) {
+            // 每次零扩展4个字节到32位
+            __m128i* dst = reinterpret_cast<__m128i*>(acc + i + 4 * k);
+            _mm_storeu_si128(dst, _mm_add_epi32(_mm_loadu_si128(dst), _mm_cvtepu8_epi32(v)));
+            v = _mm_srli_si128(v, 4);
+        }
+    }
+    accumulate_row_c(row + i, acc + i, n - i);
+}
+
+const PixFmtKernels kKernelsSSE4 = {"sse4", deinterleave_uv_sse4, average_rows_sse4, yuyv_to_yuv420_sse4,
+                                    box2_row_sse4, box4_row_sse4, sad_row_sse4, sse_row_sse4, ssim_4x4_row_sse4,
+                                    accumulate_row_sse4};
+
+// ====================== AVX2 ======================
+
+SIMD_TARGET_AVX2
+void deinterleave_uv_avx2(const uint8_t* uv, uint8_t* u, uint8_t* v, int n) {
+    const __m256i shuf = _mm256_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15,
+                                          0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15);
+    int i = 0;
+    for (; i + 32 <= n; i += 32) {
+        // 每个128位通道内先分成 [U8 V8]，再跨通道重排成 [U16 | V16]
+        __m256i a = _mm256_shuffle_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(uv + 2 * i)), shuf);
+        __m256i b = _mm256_shuffle_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(uv + 2 * i + 32)), shuf);
+        a = _mm256_permute4x64_epi64(a, 0xD8);
+        b = _mm256_permute4x64_epi64(b, 0xD8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(u + i), _mm256_permute2x128_si256(a, b, 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(v + i), _mm256_permute2x128_si256(a, b, 0x31));
+    }
+    deinterleave_uv_sse4(uv + 2 * i, u + i, v + i, n - i);
+}
+
+SIMD_TARGET_AVX2
+void average_rows_avx2(const uint8_t* a, const uint8_t* b, uint8_t* dst, int n) {
+    int i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_avg_epu8(x, y));
+    }
+    average_rows_sse4(a + i, b + i, dst + i, n - i);
+}
+
+SIMD_TARGET_AVX2
+void yuyv_to_yuv420_avx2(const uint8_t* row0, const uint8_t* row1,
+                         uint8_t* y0, uint8_t* y1, uint8_t* u, uint8_t* v, int width) {
+    const __m256i mask = _mm256_set1_epi16(0x00ff);
+    const __m256i shuf = _mm256_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15,
+                                          0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15);
+    int x = 0;
+    for (; x + 32 <= width; x += 32) {
+        __m256i a0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row0 + 2 * x));
+        __m256i a1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row0 + 2 * x + 32));
+        __m256i b0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row1 + 2 * x));
+        __m256i b1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row1 + 2 * x + 32));
+
+        // packus按128位通道打包，结果的64位块顺序为0,2,1,3，用0xD8恢复
+        __m256i ya = _mm256_packus_epi16(_mm256_and_si256(a0, mask), _mm256_and_si256(a1, mask));
+        __m256i yb = _mm256_packus_epi16(_mm256_and_si256(b0, mask), _mm256_and_si256(b1, mask));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(y0 + x), _mm256_permute4x64_epi64(ya, 0xD8));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(y1 + x), _mm256_permute4x64_epi64(yb, 0xD8));
+
+        __m256i ca = _mm256_packus_epi16(_mm256_srli_epi16(a0, 8), _mm256_srli_epi16(a1, 8));
+        __m256i cb = _mm256_packus_epi16(_mm256_srli_epi16(b0, 8), _mm256_srli_epi16(b1, 8));
+        __m256i c = _mm256_permute4x64_epi64(_mm256_avg_epu8(ca, cb), 0xD8);
+        c = _mm256_permute4x64_epi64(_mm256_shuffle_epi8(c, shuf), 0xD8);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(u + x / 2), _mm256_castsi256_si128(c));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(v + x / 2), _mm256_extracti128_si256(c, 1));
+    }
+    yuyv_to_yuv420_sse4(row0 + 2 * x, row1 + 2 * x, y0 + x, y1 + x, u + x / 2, v + x / 2, width - x);
+}
+
+SIMD_TARGET_AVX2
+inline __m256i pair_sums_avx2(const uint8_t* p) {
+    return _mm256_maddubs_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)), _mm256_set1_epi8(1));
+}
+
+SIMD_TARGET_AVX2
+void box2_row_avx2(const uint8_t* r0, const uint8_t* r1, uint8_t* dst, int dst_w) {
+    const __m256i two = _mm256_set1_epi16(2);
+    int x = 0;
+    for (; x + 32 <= dst_w; x += 32) {
+        __m256i lo = _mm256_add_epi16(pair_sums_avx2(r0 + 2 * x), pair_sums_avx2(r1 + 2 * x));
+        __m256i hi = _mm256_add_epi16(pair_sums_avx2(r0 + 2 * x + 32), pair_sums_avx2(r1 + 2 * x + 32));
+        lo = _mm256_srli_epi16(_mm256_add_epi16(lo, two), 2);
+        hi = _mm256_srli_epi16(_mm256_add_epi16(hi, two), 2);
+        // packus按通道交错，0xD8恢复顺序
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x),
+                            _mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi), 0xD8));
+    }
+    box2_row_sse4(r0 + 2 * x, r1 + 2 * x, dst + x, dst_w - x);
+}
+
+SIMD_TARGET_AVX2
+void box4_row_avx2(const uint8_t* r0, const uint8_t* r1, const uint8_t* r2, const uint8_t* r3,
+                   uint8_t* dst, int dst_w) {
+    const __m256i ones = _mm256_set1_epi16(1);
+    const __m256i eight = _mm256_set1_epi32(8);
+    int x = 0;
+    for (; x + 16 <= dst_w; x += 16) {
+        __m256i q[2];
+        for (int k = 0; k < 2; k++) {
+            int off = 4 * x + 32 * k;
+            __m256i s = _mm256_add_epi16(_mm256_add_epi16(pair_sums_avx2(r0 + off), pair_sums_avx2(r1 + off)),
+                                         _mm256_add_epi16(pair_sums_avx2(r2 + off), pair_sums_avx2(r3 + off)));
+            q[k] = _mm256_srli_epi32(_mm256_add_epi32(_mm256_madd_epi16(s, ones), eight), 4);
+        }
+        __m256i w = _mm256_permute4x64_epi64(_mm256_packs_epi32(q[0], q[1]), 0xD8);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x),
+                         _mm_packus_epi16(_mm256_castsi256_si128(w), _mm256_extracti128_si256(w, 1)));
+    }
+    box4_row_sse4(r0 + 4 * x, r1 + 4 * x, r2 + 4 * x, r3 + 4 * x, dst + x, dst_w - x);
+}
+
+SIMD_TARGET_AVX2
+uint32_t sad_row_avx2(const uint8_t* a, const uint8_t* b, int n) {
+    __m256i acc = _mm256_setzero_si256();
+    int i = 0;
+    for (; i + 32 <= n; i += 32) {
+        acc = _mm256_add_epi64(acc, _mm256_sad_epu8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i)),
+                                                    _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i))));
+    }
+    __m128i s = _mm_add_epi64(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+    uint32_t sum = static_cast<uint32_t>(_mm_cvtsi128_si32(s) + _mm_extract_epi32(s, 2));
+    return sum + sad_row_sse4(a + i, b + i, n - i);
+}
+
+SIMD_TARGET_AVX2
+uint64_t sse_row_avx2(const uint8_t* a, const uint8_t* b, int n) {
+    __m256i acc64 = _mm256_setzero_si256();
+    int i = 0;
+    while (i + 32 <= n) {
+        __m256i acc = _mm256_setzero_si256();
+        int end = std::min(n, i + kSseChunk);
+        for (; i + 32 <= end; i += 32) {
+            __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+            __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+            __m256i dlo = _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm256_castsi256_si128(va)),
+                                           _mm256_cvtepu8_epi16(_mm256_castsi256_si128(vb)));
+            __m256i dhi = _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm256_extracti128_si256(va, 1)),
+                                           _mm256_cvtepu8_epi16(_mm256_extracti128_si256(vb, 1)));
+            acc = _mm256_add_epi32(acc, _mm256_add_epi32(_mm256_madd_epi16(dlo, dlo), _mm256_madd_epi16(dhi, dhi)));
+        }
+        acc64 = _mm256_add_epi64(acc64, _mm256_add_epi64(_mm256_cvtepu32_epi64(_mm256_castsi256_si128(acc)),
+                                                         _mm256_cvtepu32_epi64(_mm256_extracti128_si256(acc, 1))));
+    }
+    uint64_t lanes[4];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), acc64);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] + sse_row_sse4(a + i, b + i, n - i);
+}
+
+SIMD_TARGET_AVX2
+void ssim_4x4_row_avx2(const uint8_t* a, ptrdiff_t a_stride, const uint8_t* b, ptrdiff_t b_stride,
+                       int32_t (*sums)[4], int blocks) {
+    const __m256i ones8 = _mm256_set1_epi8(1);
+    const __m256i ones16 = _mm256_set1_epi16(1);
+    int z = 0;
+    for (; z + 8 <= blocks; z += 8) {
+        __m256i s1 = _mm256_setzero_si256(), s2 = _mm256_setzero_si256();
+        __m256i ss_lo = _mm256_setzero_si256(), ss_hi = _mm256_setzero_si256();
+        __m256i s12_lo = _mm256_setzero_si256(), s12_hi = _mm256_setzero_si256();
+        for (int y = 0; y < 4; y++) {
+            __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + 4 * z + y * a_stride));
+            __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + 4 * z + y * b_stride));
+            s1 = _mm256_add_epi16(s1, _mm256_maddubs_epi16(va, ones8));
+            s2 = _mm256_add_epi16(s2, _mm256_maddubs_epi16(vb, ones8));
+            __m256i alo = _mm256_cvtepu8_epi16(_mm256_castsi256_si128(va));
+            __m256i ahi = _mm256_cvtepu8_epi16(_mm256_extracti128_si256(va, 1));
+            __m256i blo = _mm256_cvtepu8_epi16(_mm256_castsi256_si128(vb));
+            __m256i bhi = _mm256_cvtepu8_epi16(_mm256_extracti128_si256(vb, 1));
+            ss_lo = _mm256_add_epi32(ss_lo, _mm256_add_epi32(_mm256_madd_epi16(alo, alo), _mm256_madd_epi16(blo, blo)));
+            ss_hi = _mm256_add_epi32(ss_hi, _mm256_add_epi32(_mm256_madd_epi16(ahi, ahi), _mm256_madd_epi16(bhi, bhi)));
+            s12_lo = _mm256_add_epi32(s12_lo, _mm256_madd_epi16(alo, blo));
+            s12_hi = _mm256_add_epi32(s12_hi, _mm256_madd_epi16(ahi, bhi));
+        }
+        __m256i v0 = _mm256_madd_epi16(s1, ones16);
+        __m256i v1 = _mm256_madd_epi16(s2, ones16);
+        // vphaddd按128位通道交错，得到块序 0 1 4 5 | 2 3 6 7，再按64位重排
+        __m256i v2 = _mm256_permute4x64_epi64(_mm256_hadd_epi32(ss_lo, ss_hi), 0xD8);
+        __m256i v3 = _mm256_permute4x64_epi64(_mm256_hadd_epi32(s12_lo, s12_hi), 0xD8);
+        // 每个128位通道内转置：低通道得到块0~3，高通道得到块4~7
+        __m256i t0 = _mm256_unpacklo_epi32(v0, v1), t1 = _mm256_unpacklo_epi32(v2, v3);
+        __m256i t2 = _mm256_unpackhi_epi32(v0, v1), t3 = _mm256_unpackhi_epi32(v2, v3);
+        __m256i r[4] = {_mm256_unpacklo_epi64(t0, t1), _mm256_unpackhi_epi64(t0, t1),
+                        _mm256_unpacklo_epi64(t2, t3), _mm256_unpackhi_epi64(t2, t3)};
+        for (int k = 0; k < 4; k++) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(sums[z + k]), _mm256_castsi256_si128(r[k]));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(sums[z + 4 + k]), _mm256_extracti128_si256(r[k], 1));
+        }
+    }
+    ssim_4x4_row_sse4(a + 4 * z, a_stride, b + 4 * z, b_stride, sums + z, blocks - z);
+}
+
+SIMD_TARGET_AVX2
+void accumulate_row_avx2(const uint8_t* row, uint32_t* acc, int n) {
+    int i = 0;
+    for (; i + 32 <= n; i += 32) {
+        for (int k = 0; k < 4; k++) {
+            __m128i v = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(row + i + 8 * k));
+            __m256i* dst = reinterpret_cast<__m256i*>(acc + i + 8 * k);
+            _mm256_storeu_si256(dst, _mm256_add_epi32(_mm256_loadu_si256(dst), _mm256_cvtepu8_epi32(v)));
+        }
+    }
+    accumulate_row_sse4(row + i, acc + i, n - i);
+}
+
+const PixFmtKernels kKernelsAVX2 = {"avx2", deinterleave_uv_avx2, average_rows_avx2, yuyv_to_yuv420_avx2,
+                                    box2_row_avx2, box4_row_avx2, sad_row_avx2, sse_row_avx2, ssim_4x4_row_avx2,
+                                    accumulate_row_avx2};
+#endif
+
+#if SIMD_NEON
+// ====================== NEON ======================
+
+void deinterleave_uv_neon(const uint8_t* uv, uint8_t* u, uint8_t* v, int n) {
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        uint8x16x2_t p = vld2q_u8(uv + 2 * i);
+        vst1q_u8(u + i, p.val[0]);
+        vst1q_u8(v + i, p.val[1]);
+    }
+    deinterleave_uv_c(uv + 2 * i, u + i, v + i, n - i);
+}
+
+void average_rows_neon(const uint8_t* a, const uint8_t* b, uint8_t* dst, int n) {
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        vst1q_u8(dst + i, vrhaddq_u8(vld1q_u8(a + i), vld1q_u8(b + i)));
+    }
+    average_rows_c(a + i, b + i, dst + i, n - i);
+}
+
+void yuyv_to_yuv420_neon(const uint8_t* row0, const uint8_t* row1,
+                         uint8_t* y0, uint8_t* y1, uint8_t* u, uint8_t* v, int width) {
+    int x = 0;
+    for (; x + 32 <= width; x += 32) {
+        // vld4按字节轮流拆成 Y偶、U、Y奇、V 四路
+        uint8x16x4_t a = vld4q_u8(row0 + 2 * x);
+        uint8x16x4_t b = vld4q_u8(row1 + 2 * x);
+        uint8x16x2_t ya = {{a.val[0], a.val[2]}};
+        uint8x16x2_t yb = {{b.val[0], b.val[2]}};
+        vst2q_u8(y0 + x, ya);
+        vst2q_u8(y1 + x, yb);
+        vst1q_u8(u + x / 2, vrhaddq_u8(a.val[1], b.val[1]));
+        vst1q_u8(v + x / 2, vrhaddq_u8(a.val[3], b.val[3]));
+    }
+    yuyv_to_yuv420_tail(row0, row1, y0, y1, u, v, x, width);
+}
+
+void box2_row_neon(const uint8_t* r0, const uint8_t* r1, uint8_t* dst, int dst_w) {
+    int x = 0;
+    for (; x + 16 <= dst_w; x += 16) {
+        uint16x8_t lo = vaddq_u16(vpaddlq_u8(vld1q_u8(r0 + 2 * x)), vpaddlq_u8(vld1q_u8(r1 + 2 * x)));
+        uint16x8_t hi = vaddq_u16(vpaddlq_u8(vld1q_u8(r0 + 2 * x + 16)), vpaddlq_u8(vld1q_u8(r1 + 2 * x + 16)));
+        // vrshrn：(x + 2) >> 2 并收窄
+        vst1q_u8(dst + x, vcombine_u8(vrshrn_n_u16(lo, 2), vrshrn_n_u16(hi, 2)));
+    }
+    box2_row_c(r0 + 2 * x, r1 + 2 * x, dst + x, dst_w - x);
+}
+
+void box4_row_neon(const uint8_t* r0, const uint8_t* r1, const uint8_t* r2, const uint8_t* r3,
+                   uint8_t* dst, int dst_w) {
+    int x = 0;
+    for (; x + 8 <= dst_w; x += 8) {
+        uint16x8_t s[2];
+        for (int k = 0; k < 2; k++) {
+            int off = 4 * x + 16 * k;
+            s[k] = vaddq_u16(vaddq_u16(vpaddlq_u8(vld1q_u8(r0 + off)), vpaddlq_u8(vld1q_u8(r1 + off))),
+                             vaddq_u16(vpaddlq_u8(vld1q_u8(r2 + off)), vpaddlq_u8(vld1q_u8(r3 + off))));
+        }
+        // vpadd在32位ARM上只有64位版本，分两半做
+        uint16x8_t sums = vcombine_u16(vpadd_u16(vget_low_u16(s[0]), vget_high_u16(s[0])),
+                                       vpadd_u16(vget_low_u16(s[1]), vget_high_u16(s[1])));
+        vst1_u8(dst + x, vrshrn_n_u16(sums, 4));
+    }
+    box4_row_c(r0 + 4 * x, r1 + 4 * x, r2 + 4 * x, r3 + 4 * x, dst + x, dst_w - x);
+}
+
+uint32_t sad_row_neon(const uint8_t* a, const uint8_t* b, int n) {
+    uint32x4_t acc = vdupq_n_u32(0);
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        uint8x16_t d = vabdq_u8(vld1q_u8(a + i), vld1q_u8(b + i));
+        acc = vpadalq_u16(acc, vpaddlq_u8(d));
+    }
+    uint64x2_t s = vpaddlq_u32(acc);
+    uint32_t sum = static_cast<uint32_t>(vgetq_lane_u64(s, 0) + vgetq_lane_u64(s, 1));
+    return sum + sad_row_c(a + i, b + i, n - i);
+}
+
+uint64_t sse_row_neon(const uint8_t* a, const uint8_t* b, int n) {
+    uint64x2_t acc64 = vdupq_n_u64(0);
+    int i = 0;
+    while (i + 16 <= n) {
+        uint32x4_t acc = vdupq_n_u32(0);
+        int end = std::min(n, i + kSseChunk);
+        for (; i + 16 <= end; i += 16) {
+            // |a-b|的平方不超过255²，vmull到16位即可
+            uint8x16_t d = vabdq_u8(vld1q_u8(a + i), vld1q_u8(b + i));
+            acc = vpadalq_u16(acc, vmull_u8(vget_low_u8(d), vget_low_u8(d)));
+            acc = vpadalq_u16(acc, vmull_u8(vget_high_u8(d), vget_high_u8(d)));
+        }
+        acc64 = vpadalq_u32(acc64, acc);
+    }
+    return vgetq_lane_u64(acc64, 0) + vgetq_lane_u64(acc64, 1) + sse_row_c(a + i, b + i, n - i);
+}
+
+void ssim_4x4_row_neon(const uint8_t* a, ptrdiff_t a_stride, const uint8_t* b, ptrdiff_t b_stride,
+                       int32_t (*sums)[4], int blocks) {
+    int z = 0;
+    for (; z + 4 <= blocks; z += 4) {
+        uint16x8_t s1 = vdupq_n_u16(0), s2 = vdupq_n_u16(0);
+        uint32x4_t ss_lo = vdupq_n_u32(0), ss_hi = vdupq_n_u32(0);
+        uint32x4_t s12_lo = vdupq_n_u32(0), s12_hi = vdupq_n_u32(0);
+        for (int y = 0; y < 4; y++) {
+            uint8x16_t va = vld1q_u8(a + 4 * z + y * a_stride);
+            uint8x16_t vb = vld1q_u8(b + 4 * z + y * b_stride);
+            s1 = vpadalq_u8(s1, va);
+            s2 = vpadalq_u8(s2, vb);
+            ss_lo = vpadalq_u16(ss_lo, vmull_u8(vget_low_u8(va), vget_low_u8(va)));
+            ss_lo = vpadalq_u16(ss_lo, vmull_u8(vget_low_u8(vb), vget_low_u8(vb)));
+            ss_hi = vpadalq_u16(ss_hi, vmull_u8(vget_high_u8(va), vget_high_u8(va)));
+            ss_hi = vpadalq_u16(ss_hi, vmull_u8(vget_high_u8(vb), vget_high_u8(vb)));
+            s12_lo = vpadalq_u16(s12_lo, vmull_u8(vget_low_u8(va), vget_low_u8(vb)));
+            s12_hi = vpadalq_u16(s12_hi, vmull_u8(vget_high_u8(va), vget_high_u8(vb)));
+        }
+        uint32x4x4_t v;
+        v.val[0] = vpaddlq_u16(s1);
+        v.val[1] = vpaddlq_u16(s2);
+        v.val[2] = vcombine_u32(vpadd_u32(vget_low_u32(ss_lo), vget_high_u32(ss_lo)),
+                                vpadd_u32(vget_low_u32(ss_hi), vget_high_u32(ss_hi)));
+        v.val[3] = vcombine_u32(vpadd_u32(vget_low_u32(s12_lo), vget_high_u32(s12_lo)),
+                                vpadd_u32(vget_low_u32(s12_hi), vget_high_u32(s12_hi)));
+        // vst4交错存储，正好是每块一组 {s1, s2, ss, s12}
+        vst4q_u32(reinterpret_cast<uint32_t*>(sums[z]), v);
+    }
+    ssim_4x4_row_c(a + 4 * z, a_stride, b + 4 * z, b_stride, sums + z, blocks - z);
+}
+
+void accumulate_row_neon(const uint8_t* row, uint32_t* acc, int n) {
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        uint8x16_t v = vld1q_u8(row + i);
+        uint16x8_t lo = vmovl_u8(vget_low_u8(v));
+        uint16x8_t hi = vmovl_u8(vget_high_u8(v));
+        vst1q_u32(acc + i, vaddw_u16(vld1q_u32(acc + i), vget_low_u16(lo)));
+        vst1q_u32(acc + i + 4, vaddw_u16(vld1q_u32(acc + i + 4), vget_high_u16(lo)));
+        vst1q_u32(acc + i + 8, vaddw_u16(vld1q_u32(acc + i + 8), vget_low_u16(hi)));
+        vst1q_u32(acc + i + 12, vaddw_u16(vld1q_u32(acc + i + 12), vget_high_u16(hi)));
+    }
+    accumulate_row_c(row + i, acc + i, n - i);
+}
+
+const PixFmtKernels kKernelsNEON = {"neon", deinterleave_uv_neon, average_rows_neon, yuyv_to_yuv420_neon,
+                                    box2_row_neon, box4_row_neon, sad_row_neon, sse_row_neon, ssim_4x4_row_neon,
+                                    accumulate_row_neon};
+#endif
+
+} // namespace
+
+std::vector<const PixFmtKernels*> pixfmt_kernels_available() {
+    std::vector<const PixFmtKernels*> list = {&kKernelsC};
+    int flags = av_get_cpu_flags();
+#if SIMD_X86
+    if (flags & AV_CPU_FLAG_SSE4) list.push_back(&kKernelsSSE4);
+    if (flags & AV_CPU_FLAG_AVX2) list.push_back(&kKernelsAVX2);
+#endif
+#if SIMD_NEON
+    if (flags & AV_CPU_FLAG_NEON) list.push_back(&kKernelsNEON);
+#endif
+    (void)flags;
+    return list;
+}
+
+const PixFmtKernels& pixfmt_kernels() {
+    // 可用列表按能力递增排列，取最后一个
+    static const PixFmtKernels* best = pixfmt_kernels_available().back();
+    return *best;
+}
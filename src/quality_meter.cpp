@@ -0,0 +1,320 @@
+//
+// Created by Jianing on 2026/01/25.
+//
+#include "quality_meter.h"
+#include "pixfmt_kernels.h"
+#include "job_stats.h"
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+extern "C" {
+#include <libavutil/pixdesc.h>
+}
+
+namespace {
+
+double sse_to_psnr(uint64_t sse, double pixels) {
+    if (sse == 0 || pixels <= 0) {
+        return QualityMeter::kMaxPsnr;
+    }
+    double mse = static_cast<double>(sse) / pixels;
+    return std::min(10.0 * std::log10(255.0 * 255.0 / mse), QualityMeter::kMaxPsnr);
+}
+
+uint64_t plane_sse(const PixFmtKernels& k, const uint8_t* a, int a_stride, const uint8_t* b, int b_stride,
+                   int w, int h) {
+    uint64_t sse = 0;
+    for (int y = 0; y < h; y++) {
+        sse += k.sse_row(a + static_cast<ptrdiff_t>(y) * a_stride, b + static_cast<ptrdiff_t>(y) * b_stride, w);
+    }
+    return sse;
+}
+
+// 8x8窗口（相邻2x2个4x4块的统计量之和）的SSIM，常数与x264/libavfilter一致
+double ssim_window(const int32_t* s00, const int32_t* s01, const int32_t* s10, const int32_t* s11) {
+    const double c1 = .01 * .01 * 255 * 255 * 64;
+    const double c2 = .03 * .03 * 255 * 255 * 64 * 63;
+    int64_t s1 = s00[0] + s01[0] + s10[0] + s11[0];
+    int64_t s2 = s00[1] + s01[1] + s10[1] + s11[1];
+    int64_t ss = s00[2] + s01[2] + s10[2] + s11[2];
+    int64_t s12 = s00[3] + s01[3] + s10[3] + s11[3];
+    double vars = static_cast<double>(ss * 64 - s1 * s1 - s2 * s2);
+    double covar = static_cast<double>(s12 * 64 - s1 * s2);
+    return (2.0 * s1 * s2 + c1) * (2.0 * covar + c2) /
+           ((static_cast<double>(s1 * s1 + s2 * s2) + c1) * (vars + c2));
+}
+
+// 窗口以4像素步长重叠滑动，逐条带求4x4块统计量，只保留上一条带
+double plane_ssim(const PixFmtKernels& k, const uint8_t* a, int a_stride, const uint8_t* b, int b_stride,
+                  int w, int h) {
+    const int bw = w / 4;
+    const int bh = h / 4;
+    if (bw < 2 || bh < 2) {
+        return 1.0;
+    }
+    std::vector<int32_t> buf(static_cast<size_t>(8) * bw);
+    int32_t (*prev)[4] = reinterpret_cast<int32_t(*)[4]>(buf.data());
+    int32_t (*cur)[4] = prev + bw;
+
+    double total = 0;
+    k.ssim_4x4_row(a, a_stride, b, b_stride, prev, bw);
+    for (int y = 1; y < bh; y++) {
+        k.ssim_4x4_row(a + static_cast<ptrdiff_t>(4 * y) * a_stride, a_stride,
+                       b + static_cast<ptrdiff_t>(4 * y) * b_stride, b_stride, cur, bw);
+        for (int x = 0; x + 1 < bw; x++) {
+            total += ssim_window(prev[x], prev[x + 1], cur[x], cur[x + 1]);
+        }
+        std::swap(prev, cur);
+    }
+    return total / (static_cast<double>(bw - 1) * (bh - 1));
+}
+
+void write_score(std::ofstream& out, double value) {
+    out << ',' << std::fixed << std::setprecision(4) << value;
+}
+
+} // namespace
+
+QualityMeter::QualityMeter(const QualityMeterOptions& options) : opts(options) {
+    opts.sample_interval = std::max(opts.sample_interval, 1);
+}
+
+QualityMeter::~QualityMeter() {
+    for (auto& entry : sources) {
+        av_frame_free(&entry.second);
+    }
+    av_frame_free(&recon);
+    avcodec_free_context(&dec_ctx);
+}
+
+FrameQuality QualityMeter::compare(const AVFrame* ref, const AVFrame* dist) {
+    const PixFmtKernels& k = pixfmt_kernels();
+    const int w = ref->width;
+    const int h = ref->height;
+    const int pw[3] = {w, (w + 1) >> 1, (w + 1) >> 1};
+    const int ph[3] = {h, (h + 1) >> 1, (h + 1) >> 1};
+
+    uint64_t sse[3];
+    double ssim[3];
+    for (int p = 0; p < 3; p++) {
+        sse[p] = plane_sse(k, ref->data[p], ref->linesize[p], dist->data[p], dist->linesize[p], pw[p], ph[p]);
+        ssim[p] = plane_ssim(k, ref->data[p], ref->linesize[p], dist->data[p], dist->linesize[p], pw[p], ph[p]);
+    }
+
+    const double luma = static_cast<double>(pw[0]) * ph[0];
+    const double chroma = static_cast<double>(pw[1]) * ph[1];
+    FrameQuality q;
+    q.psnr_y = sse_to_psnr(sse[0], luma);
+    q.psnr_u = sse_to_psnr(sse[1], chroma);
+    q.psnr_v = sse_to_psnr(sse[2], chroma);
+    q.psnr = sse_to_psnr(sse[0] + sse[1] + sse[2], luma + 2 * chroma);
+    q.ssim_y = ssim[0];
+    // 与libavfilter ssim一致：各平面按像素数加权
+    q.ssim = (ssim[0] * luma + (ssim[1] + ssim[2]) * chroma) / (luma + 2 * chroma);
+    return q;
+}
+
+bool QualityMeter::open(const AVCodecContext* enc_ctx) {
+    const AVCodec* decoder = avcodec_find_decoder(enc_ctx->codec_id);
+    if (!decoder) {
+        std::cerr << "[QualityMeter Error] 找不到 " << avcodec_get_name(enc_ctx->codec_id) << " 解码器\n";
+        return false;
+    }
+
+    dec_ctx = avcodec_alloc_context3(decoder);
+    AVCodecParameters* par = avcodec_parameters_alloc();
+    int ret = dec_ctx && par ? avcodec_parameters_from_context(par, enc_ctx) : AVERROR(ENOMEM);
+    if (ret >= 0) {
+        ret = avcodec_parameters_to_context(dec_ctx, par);
+    }
+    avcodec_parameters_free(&par);
+    if (ret >= 0) {
+        dec_ctx->pkt_timebase = enc_ctx->time_base;
+        // 单线程解码：帧级多线程会让重建帧延后几帧输出，源帧引用就得多留几帧
+        dec_ctx->thread_count = 1;
+        ret = avcodec_open2(dec_ctx, decoder, nullptr);
+    }
+    recon = av_frame_alloc();
+    if (ret >= 0 && !recon) {
+        ret = AVERROR(ENOMEM);
+    }
+    if (ret < 0) {
+        char err_buf[1024];
+        av_strerror(ret, err_buf, sizeof(err_buf));
+        std::cerr << "[QualityMeter Error] 打开重建解码器失败：" << err_buf << "\n";
+        av_frame_free(&recon);
+        avcodec_free_context(&dec_ctx);
+        return false;
+    }
+
+    if (!opts.frame_csv.empty()) {
+        frame_out.open(opts.frame_csv);
+        frame_out << "frame,pts,type,psnr_y,psnr_u,psnr_v,psnr,ssim_y,ssim\n";
+    }
+    if (!opts.gop_csv.empty()) {
+        gop_out.open(opts.gop_csv);
+        gop_out << "gop,first_frame,frames,scored,bytes,psnr_avg,psnr_min,ssim_avg,ssim_min\n";
+    }
+
+    if (!opts.report) {
+        return true;
+    }
+    // 【一次性信息】保留
+    std::cout << "[QualityMeter Info] 启用PSNR/SSIM评估（" << pixfmt_kernels().name << "内核，每"
+              << opts.sample_interval << "帧评估一帧）\n";
+    return true;
+}
+
+void QualityMeter::add_source(const AVFrame* frame) {
+    int64_t index = source_count++;
+    if (!dec_ctx || index % opts.sample_interval != 0 || frame->pts == AV_NOPTS_VALUE) {
+        return;
+    }
+    AVFrame* ref = av_frame_alloc();
+    if (!ref || av_frame_ref(ref, frame) < 0) {
+        av_frame_free(&ref);
+        return;
+    }
+    AVFrame*& slot = sources[frame->pts];
+    av_frame_free(&slot);
+    slot = ref;
+}
+
+void QualityMeter::on_packet(const AVPacket* pkt) {
+    if (!dec_ctx || finished) {
+        return;
+    }
+    ScopedTimer timer(g_job_stats, "quality.meter");
+    int ret = avcodec_send_packet(dec_ctx, pkt);
+    if (ret < 0) {
+        char err_buf[1024];
+        av_strerror(ret, err_buf, sizeof(err_buf));
+        std::cerr << "[QualityMeter Warn] 重建解码送包失败：" << err_buf << "\n";
+        return;
+    }
+    receive_frames();
+}
+
+void QualityMeter::receive_frames() {
+    while (true) {
+        int ret = avcodec_receive_frame(dec_ctx, recon);
+        if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
+            return;
+        }
+        if (ret < 0) {
+            char err_buf[1024];
+            av_strerror(ret, err_buf, sizeof(err_buf));
+            std::cerr << "[QualityMeter Warn] 重建解码失败：" << err_buf << "\n";
+            return;
+        }
+        on_reconstructed(recon);
+        av_frame_unref(recon);
+    }
+}
+
+void QualityMeter::on_reconstructed(const AVFrame* frame) {
+    int64_t index = recon_count++;
+    int64_t pts = frame->pts != AV_NOPTS_VALUE ? frame->pts : frame->best_effort_timestamp;
+
+    if (frame->key_frame || gop.index < 0) {
+        int64_t next = gop.index + 1;
+        close_gop();
+        gop = GopAccum();
+        gop.index = next;
+        gop.first_frame = index;
+    }
+    gop.frames++;
+    gop.bytes += std::max(frame->pkt_size, 0);
+
+    // 重建帧按显示顺序输出：更早的源帧已不会再被匹配（编码器丢帧或解码失败），直接释放
+    while (!sources.empty() && sources.begin()->first < pts) {
+        av_frame_free(&sources.begin()->second);
+        sources.erase(sources.begin());
+    }
+    auto it = sources.find(pts);
+    if (it == sources.end()) {
+        return;  // 未抽中的帧
+    }
+    AVFrame* src = it->second;
+    sources.erase(it);
+    if (src->width != frame->width || src->height != frame->height || src->format != AV_PIX_FMT_YUV420P ||
+        frame->format != AV_PIX_FMT_YUV420P) {
+        av_frame_free(&src);
+        return;
+    }
+
+    FrameQuality q;
+    {
+        ScopedTimer timer(g_job_stats, "quality.compare");
+        q = compare(src, frame);
+    }
+    av_frame_free(&src);
+
+    gop.scored++;
+    gop.psnr_sum += q.psnr;
+    gop.psnr_min = std::min(gop.psnr_min, q.psnr);
+    gop.ssim_sum += q.ssim;
+    gop.ssim_min = std::min(gop.ssim_min, q.ssim);
+    total_scored++;
+    total_psnr += q.psnr;
+    total_ssim += q.ssim;
+    total_psnr_min = std::min(total_psnr_min, q.psnr);
+
+    if (frame_out.is_open()) {
+        frame_out << index << ',' << pts << ',' << av_get_picture_type_char(frame->pict_type);
+        for (double v : {q.psnr_y, q.psnr_u, q.psnr_v, q.psnr, q.ssim_y, q.ssim}) {
+            write_score(frame_out, v);
+        }
+        frame_out << '\n';
+    }
+}
+
+void QualityMeter::close_gop() {
+    if (gop.index < 0 || !gop_out.is_open()) {
+        return;
+    }
+    gop_out << gop.index << ',' << gop.first_frame << ',' << gop.frames << ',' << gop.scored << ',' << gop.bytes;
+    if (gop.scored > 0) {
+        write_score(gop_out, gop.psnr_sum / gop.scored);
+        write_score(gop_out, gop.psnr_min);
+        write_score(gop_out, gop.ssim_sum / gop.scored);
+        write_score(gop_out, gop.ssim_min);
+    } else {
+        gop_out << ",,,,";
+    }
+    gop_out << '\n';
+}
+
+void QualityMeter::finish() {
+    if (!dec_ctx || finished) {
+        return;
+    }
+    finished = true;
+    if (avcodec_send_packet(dec_ctx, nullptr) >= 0) {
+        receive_frames();
+    }
+    close_gop();
+
+    for (auto& entry : sources) {
+        av_frame_free(&entry.second);
+    }
+    sources.clear();
+    frame_out.close();
+    gop_out.close();
+
+    if (!opts.report) {
+        return;
+    }
+    g_job_stats.add_count("quality.scored_frames", total_scored);
+    // 【退出总结】保留
+    std::cout << "[QualityMeter Info] 重建 " << recon_count << " 帧，评估 " << total_scored << " 帧";
+    if (total_scored > 0) {
+        std::cout << "：平均PSNR " << std::fixed << std::setprecision(2) << total_psnr / total_scored
+                  << " dB（最低 " << total_psnr_min << "），平均SSIM " << std::setprecision(4)
+                  << total_ssim / total_scored << std::defaultfloat;
+    }
+    std::cout << "\n";
+}
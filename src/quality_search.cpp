@@ -0,0 +1,318 @@
+//
+// Created by Jianing on 2026/01/30.
+//
+#include "quality_search.h"
+#include "quality_meter.h"
+#include "video_scaler.h"
+#include "job_stats.h"
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+}
+
+namespace {
+
+// 一个候选点在一段上的试编码结果
+struct PointResult {
+    bool ok = false;
+    double psnr = 0;
+    double ssim = 0;
+    int64_t bytes = 0;
+    int frames = 0;
+};
+
+// 取样起点（流时间基）：有关键帧索引时在全部关键帧中均匀选，否则按时长均匀选（seek时向前对齐关键帧）
+std::vector<int64_t> pick_sample_points(AVFormatContext* fmt_ctx, AVStream* stream, int samples) {
+    std::vector<int64_t> keyframes;
+    for (int i = 0; i < stream->nb_index_entries; i++) {
+        if (stream->index_entries[i].flags & AVINDEX_KEYFRAME) {
+            keyframes.push_back(stream->index_entries[i].timestamp);
+        }
+    }
+
+    std::vector<int64_t> points;
+    if (!keyframes.empty()) {
+        for (int i = 0; i < samples; i++) {
+            size_t idx = static_cast<size_t>((2 * i + 1) * keyframes.size() / (2 * static_cast<size_t>(samples)));
+            int64_t ts = keyframes[std::min(idx, keyframes.size() - 1)];
+            if (points.empty() || points.back() != ts) {  // 关键帧比取样数少时会重复
+                points.push_back(ts);
+            }
+        }
+        return points;
+    }
+
+    int64_t start = stream->start_time != AV_NOPTS_VALUE ? stream->start_time : 0;
+    int64_t duration = stream->duration;
+    if (duration <= 0 && fmt_ctx->duration > 0) {
+        duration = av_rescale_q(fmt_ctx->duration, AV_TIME_BASE_Q, stream->time_base);
+    }
+    if (duration <= 0) {
+        points.push_back(start);
+        return points;
+    }
+    for (int i = 0; i < samples; i++) {
+        points.push_back(start + av_rescale(duration, 2 * i + 1, 2 * static_cast<int64_t>(samples)));
+    }
+    return points;
+}
+
+// 用给定配置试编码一段，把Packet在进程内解码回来与源帧比较
+PointResult encode_point(const EncoderProfile& profile, int width, int height, AVRational time_base,
+                         const std::vector<AVFrame*>& frames) {
+    PointResult result;
+    AVCodecContext* enc_ctx = open_video_encoder(profile, width, height, time_base);
+    if (!enc_ctx) {
+        return result;
+    }
+    QualityMeterOptions meter_opts;
+    meter_opts.enabled = true;
+    meter_opts.frame_csv.clear();
+    meter_opts.gop_csv.clear();
+    meter_opts.report = false;
+    QualityMeter meter(meter_opts);
+    AVFrame* frame = av_frame_alloc();
+    AVPacket* pkt = av_packet_alloc();
+    if (!frame || !pkt || !meter.open(enc_ctx)) {
+        av_frame_free(&frame);
+        av_packet_free(&pkt);
+        avcodec_free_context(&enc_ctx);
+        return result;
+    }
+
+    auto drain = [&]() {
+        while (avcodec_receive_packet(enc_ctx, pkt) >= 0) {
+            result.bytes += pkt->size;
+            meter.on_packet(pkt);
+            av_packet_unref(pkt);
+        }
+    };
+    for (size_t i = 0; i < frames.size(); i++) {
+        if (av_frame_ref(frame, frames[i]) < 0) {
+            continue;
+        }
+        frame->pts = static_cast<int64_t>(i);
+        frame->pict_type = AV_PICTURE_TYPE_NONE;
+        meter.add_source(frame);
+        if (avcodec_send_frame(enc_ctx, frame) >= 0) {
+            result.frames++;
+        }
+        av_frame_unref(frame);
+        drain();
+    }
+    avcodec_send_frame(enc_ctx, nullptr);
+    drain();
+    meter.finish();
+
+    result.ok = meter.scored_frames() > 0;
+    result.psnr = meter.average_psnr();
+    result.ssim = meter.average_ssim();
+    av_frame_free(&frame);
+    av_packet_free(&pkt);
+    avcodec_free_context(&enc_ctx);
+    return result;
+}
+
+} // namespace
+
+bool decode_sample_frames(const char* input_file, int64_t start_ts, int frame_count, int width, int height,
+                          const CropRect& crop, std::vector<AVFrame*>* frames, int64_t* packet_bytes) {
+    AVFormatContext* fmt_ctx = nullptr;
+    if (avformat_open_input(&fmt_ctx, input_file, nullptr, nullptr) < 0) {
+        return false;
+    }
+    AVCodec* decoder = nullptr;  // FFmpeg 4.4的av_find_best_stream要求非const
+    int stream_idx = avformat_find_stream_info(fmt_ctx, nullptr) >= 0
+                     ? av_find_best_stream(fmt_ctx, AVMEDIA_TYPE_VIDEO, -1, -1, &decoder, 0) : -1;
+    AVCodecContext* dec_ctx = stream_idx >= 0 && decoder ? avcodec_alloc_context3(decoder) : nullptr;
+    if (!dec_ctx || avcodec_parameters_to_context(dec_ctx, fmt_ctx->streams[stream_idx]->codecpar) < 0 ||
+        avcodec_open2(dec_ctx, decoder, nullptr) < 0 ||
+        av_seek_frame(fmt_ctx, stream_idx, start_ts, AVSEEK_FLAG_BACKWARD) < 0) {
+        avcodec_free_context(&dec_ctx);
+        avformat_close_input(&fmt_ctx);
+        return false;
+    }
+
+    ScaleOptions scale_opts;
+    scale_opts.width = width;
+    scale_opts.height = height;
+    scale_opts.threads = 1;  // 并行度来自多段同时处理
+    VideoScaler scaler(scale_opts);
+    AVPacket* pkt = av_packet_alloc();
+    AVFrame* frame = av_frame_alloc();
+
+    auto take_frames = [&]() {
+        while (static_cast<int>(frames->size()) < frame_count && avcodec_receive_frame(dec_ctx, frame) >= 0) {
+            AVFrame* out = av_frame_alloc();
+            if (out && (crop.empty() || apply_crop(frame, crop) >= 0) && scaler.scale(frame, out) >= 0) {
+                frames->push_back(out);
+            } else {
+                av_frame_free(&out);
+            }
+            av_frame_unref(frame);
+        }
+    };
+
+    bool eof = false;
+    while (pkt && frame && !eof && static_cast<int>(frames->size()) < frame_count) {
+        if (av_read_frame(fmt_ctx, pkt) < 0) {
+            avcodec_send_packet(dec_ctx, nullptr);
+            eof = true;
+        } else if (pkt->stream_index == stream_idx) {
+            if (packet_bytes) {
+                *packet_bytes += pkt->size;
+            }
+            avcodec_send_packet(dec_ctx, pkt);
+        }
+        av_packet_unref(pkt);
+        take_frames();
+    }
+
+    av_frame_free(&frame);
+    av_packet_free(&pkt);
+    avcodec_free_context(&dec_ctx);
+    avformat_close_input(&fmt_ctx);
+    return !frames->empty();
+}
+
+bool search_encode_quality(const char* input_file, int width, int height, AVRational time_base,
+                           const QualitySearchOptions& opts, EncoderProfile* profile) {
+    // 候选点：按码率或按crf/qscale，都从低质量到高质量排列
+    const bool by_quality = profile->rate_control == RateControl::ConstQuality;
+    std::vector<EncoderProfile> points;
+    if (by_quality) {
+        std::vector<int> qualities = opts.qualities;
+        if (qualities.empty()) {
+            qualities = profile->codec == "mpeg4" ? std::vector<int>{16, 12, 9, 7, 5, 4, 3, 2}
+                                                  : std::vector<int>{34, 31, 28, 25, 23, 21, 19, 17};
+        }
+        for (int q : qualities) {
+            points.push_back(*profile);
+            points.back().quality = q;
+        }
+    } else {
+        for (int64_t rate : opts.bit_rates) {
+            points.push_back(*profile);
+            points.back().bit_rate = rate;
+        }
+    }
+    if (points.empty()) {
+        std::cerr << "[QualitySearch Error] 没有候选码率/质量点\n";
+        return false;
+    }
+    for (auto& point : points) {
+        point.threads = 1;  // 并行度来自多段同时处理
+    }
+
+    AVFormatContext* fmt_ctx = nullptr;
+    if (avformat_open_input(&fmt_ctx, input_file, nullptr, nullptr) < 0 ||
+        avformat_find_stream_info(fmt_ctx, nullptr) < 0) {
+        std::cerr << "[QualitySearch Error] 打开输入文件失败: " << input_file << "\n";
+        avformat_close_input(&fmt_ctx);
+        return false;
+    }
+    int stream_idx = av_find_best_stream(fmt_ctx, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+    if (stream_idx < 0) {
+        std::cerr << "[QualitySearch Error] 未找到视频流\n";
+        avformat_close_input(&fmt_ctx);
+        return false;
+    }
+    std::vector<int64_t> starts = pick_sample_points(fmt_ctx, fmt_ctx->streams[stream_idx], std::max(opts.samples, 1));
+    avformat_close_input(&fmt_ctx);
+
+    // 各段并行：解码一段后依次试编码每个候选点，结果写入各自的行，不需要加锁
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::vector<PointResult>> results(starts.size(), std::vector<PointResult>(points.size()));
+    std::atomic<size_t> next_sample(0);
+    auto worker = [&]() {
+        for (size_t s = next_sample++; s < starts.size(); s = next_sample++) {
+            std::vector<AVFrame*> frames;
+            if (decode_sample_frames(input_file, starts[s], std::max(opts.sample_frames, 1), width, height,
+                                     opts.crop, &frames)) {
+                for (size_t p = 0; p < points.size(); p++) {
+                    results[s][p] = encode_point(points[p], width, height, time_base, frames);
+                }
+            }
+            for (AVFrame*& frame : frames) {
+                av_frame_free(&frame);
+            }
+        }
+    };
+    std::vector<std::thread> threads;
+    int workers = std::min(std::max(opts.workers, 1), static_cast<int>(starts.size()));
+    for (int i = 0; i < workers; i++) {
+        threads.emplace_back(worker);
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    g_job_stats.add_time("search.quality", seconds, static_cast<int64_t>(starts.size() * points.size()));
+
+    // 每个候选点取所有成功段的平均，选第一个达标的（最低码率/质量）
+    const double frame_seconds = av_q2d(time_base);
+    int chosen = -1;
+    int last_ok = -1;  // 都不达标时取最后一个有结果的点
+    int used_samples = 0;
+    for (size_t p = 0; p < points.size(); p++) {
+        double psnr = 0, ssim = 0;
+        int64_t bytes = 0, frames = 0;
+        int ok = 0;
+        for (size_t s = 0; s < starts.size(); s++) {
+            const PointResult& r = results[s][p];
+            if (!r.ok) {
+                continue;
+            }
+            psnr += r.psnr;
+            ssim += r.ssim;
+            bytes += r.bytes;
+            frames += r.frames;
+            ok++;
+        }
+        if (ok == 0) {
+            continue;
+        }
+        used_samples = std::max(used_samples, ok);
+        psnr /= ok;
+        ssim /= ok;
+        bool meets = ssim >= opts.target_ssim && (opts.target_psnr <= 0 || psnr >= opts.target_psnr);
+        double kbps = frames > 0 ? bytes * 8.0 / (frames * frame_seconds) / 1000.0 : 0.0;
+        std::cout << "[QualitySearch Info] "
+                  << (by_quality ? "q=" + std::to_string(points[p].quality)
+                                 : std::to_string(points[p].bit_rate / 1000) + "k")
+                  << "：SSIM " << std::fixed << std::setprecision(4) << ssim << "，PSNR " << std::setprecision(2)
+                  << psnr << " dB，实际 " << std::setprecision(0) << kbps << " kbps" << std::defaultfloat
+                  << (meets ? "（达标）" : "") << "\n";
+        last_ok = static_cast<int>(p);
+        if (meets) {
+            chosen = last_ok;
+            break;
+        }
+    }
+
+    if (last_ok < 0) {
+        std::cerr << "[QualitySearch Error] 取样段解码/试编码全部失败，保持原设置\n";
+        return false;
+    }
+    if (chosen < 0) {
+        chosen = last_ok;
+        std::cerr << "[QualitySearch Warn] 候选点都达不到目标，取最高一档\n";
+    }
+    profile->bit_rate = points[chosen].bit_rate;
+    profile->quality = points[chosen].quality;
+
+    // 【一次性信息】保留
+    std::cout << "[QualitySearch Info] " << used_samples << " 段 x " << opts.sample_frames << " 帧，" << points.size()
+              << " 个候选点，耗时 " << seconds << " 秒 → "
+              << (by_quality ? "quality=" + std::to_string(profile->quality)
+                             : "bit_rate=" + std::to_string(profile->bit_rate / 1000) + "k")
+              << "\n";
+    return true;
+}
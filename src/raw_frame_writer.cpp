@@ -0,0 +1,230 @@
+//
+// Created by Jianing on 2026/01/10.
+//
+#include "raw_frame_writer.h"
+#include "y4m.h"
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+
+extern "C" {
+#include <libavutil/imgutils.h>
+#include <libavutil/pixdesc.h>
+}
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <limits.h>
+#include <sys/uio.h>
+#endif
+
+#if !defined(_WIN32) && !defined(IOV_MAX)
+#define IOV_MAX 1024
+#endif
+
+RawFrameWriter::RawFrameWriter(uint32_t queue_capacity) : queue(queue_capacity) {}
+
+RawFrameWriter::~RawFrameWriter() {
+    close();
+}
+
+bool RawFrameWriter::open(const std::string& file, bool write_y4m, AVRational rate) {
+    if (fd >= 0) {
+        close();
+    }
+#ifdef _WIN32
+    fd = _open(file.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+    fd = ::open(file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+#endif
+    if (fd < 0) {
+        std::cerr << "[Error] 无法打开原始帧输出文件: " << file << "\n";
+        return false;
+    }
+
+    filename = file;
+    y4m = write_y4m;
+    header_written = false;
+    failed = false;
+    frame_count = 0;
+    if (rate.num > 0 && rate.den > 0) {
+        frame_rate = rate;
+    }
+
+    queue.reset();
+    writer = std::thread(&RawFrameWriter::writer_loop, this);
+    // 【一次性信息】保留
+    std::cout << "[Info] 原始帧文件已打开: " << filename << (y4m ? "（Y4M）" : "（裸YUV）") << "\n";
+    return true;
+}
+
+bool RawFrameWriter::write_frame(const AVFrame* frame) {
+    if (fd < 0 || failed || !frame || !frame->data[0]) {
+        return false;
+    }
+    // RingBuffer::push内部av_frame_ref，只增加引用计数
+    AVFrame* ref = const_cast<AVFrame*>(frame);
+    return queue.push(ref);
+}
+
+void RawFrameWriter::close() {
+    if (fd < 0) {
+        return;
+    }
+    queue.flush();
+    if (writer.joinable()) {
+        writer.join();
+    }
+#ifdef _WIN32
+    _close(fd);
+#else
+    ::close(fd);
+#endif
+    fd = -1;
+    // 【结束信息】保留
+    std::cout << "[Info] 原始帧文件已关闭，共写入 " << frame_count << " 帧: " << filename << "\n";
+}
+
+void RawFrameWriter::writer_loop() {
+    AVFrame* frame = av_frame_alloc();
+    if (!frame) {
+        failed = true;
+        return;
+    }
+    while (queue.pop(frame)) {
+        if (!failed && !write_one(frame)) {
+            failed = true;
+            std::cerr << "[Error] 原始帧写入失败，停止导出: " << filename << "\n";
+        }
+        av_frame_unref(frame);
+    }
+    av_frame_free(&frame);
+}
+
+bool RawFrameWriter::write_y4m_header(const AVFrame* frame) {
+    auto pix_fmt = static_cast<AVPixelFormat>(frame->format);
+    const char* tag = y4m_chroma_tag(pix_fmt);
+    if (!tag) {
+        std::cerr << "[Error] Y4M不支持像素格式 " << av_get_pix_fmt_name(pix_fmt) << "\n";
+        return false;
+    }
+
+    AVRational sar = frame->sample_aspect_ratio;
+    char header[256];
+    int len = snprintf(header, sizeof(header), "YUV4MPEG2 W%d H%d F%d:%d I%c A%d:%d C%s%s\n",
+                       frame->width, frame->height, frame_rate.num, frame_rate.den,
+                       frame->interlaced_frame ? (frame->top_field_first ? 't' : 'b') : 'p',
+                       sar.num, sar.num ? sar.den : 0, tag,
+                       frame->color_range == AVCOL_RANGE_JPEG ? " XCOLORRANGE=FULL" : "");
+    return write_all({{reinterpret_cast<const uint8_t*>(header), static_cast<size_t>(len)}});
+}
+
+bool RawFrameWriter::write_one(const AVFrame* frame) {
+    auto pix_fmt = static_cast<AVPixelFormat>(frame->format);
+    const AVPixFmtDescriptor* desc = av_pix_fmt_desc_get(pix_fmt);
+    if (!desc || (desc->flags & (AV_PIX_FMT_FLAG_HWACCEL | AV_PIX_FMT_FLAG_PAL | AV_PIX_FMT_FLAG_BITSTREAM))) {
+        std::cerr << "[Error] 不支持导出的像素格式: " << (desc ? desc->name : "unknown") << "\n";
+        return false;
+    }
+
+    if (y4m && !header_written) {
+        if (!write_y4m_header(frame)) {
+            return false;
+        }
+        header_written = true;
+    }
+
+    // 每行有效字节数（紧凑排列时的linesize）
+    int row_bytes[4] = {0};
+    if (av_image_fill_linesizes(row_bytes, pix_fmt, frame->width) < 0) {
+        return false;
+    }
+
+    static const char kFrameTag[] = "FRAME\n";
+    std::vector<RawIoVec> vecs;
+    if (y4m) {
+        vecs.push_back({reinterpret_cast<const uint8_t*>(kFrameTag), sizeof(kFrameTag) - 1});
+    }
+
+    int nb_planes = av_pix_fmt_count_planes(pix_fmt);
+    for (int p = 0; p < nb_planes; p++) {
+        // 1、2平面为色度（含NV12的交错UV），按色度高度；0、3平面为亮度/alpha
+        int h = (p == 1 || p == 2) ? AV_CEIL_RSHIFT(frame->height, desc->log2_chroma_h) : frame->height;
+        const uint8_t* src = frame->data[p];
+        if (frame->linesize[p] == row_bytes[p]) {
+            vecs.push_back({src, static_cast<size_t>(row_bytes[p]) * h});
+        } else {
+            for (int y = 0; y < h; y++) {
+                vecs.push_back({src + static_cast<ptrdiff_t>(y) * frame->linesize[p],
+                                static_cast<size_t>(row_bytes[p])});
+            }
+        }
+    }
+
+    if (!write_all(vecs)) {
+        return false;
+    }
+    frame_count++;
+    // 写入日志：每100帧输出一次
+    if (frame_count % 100 == 0) {
+        std::cout << "[RawWriter] 已写入 " << frame_count << " 帧\n";
+    }
+    return true;
+}
+
+bool RawFrameWriter::write_all(const std::vector<RawIoVec>& vecs) {
+#ifdef _WIN32
+    // 无writev：合并到暂存区后一次写出
+    size_t total = 0;
+    for (const auto& v : vecs) total += v.len;
+    staging.resize(total);
+    size_t off = 0;
+    for (const auto& v : vecs) {
+        memcpy(staging.data() + off, v.base, v.len);
+        off += v.len;
+    }
+    off = 0;
+    while (off < total) {
+        unsigned int chunk = static_cast<unsigned int>(std::min<size_t>(total - off, 1u << 30));
+        int n = _write(fd, staging.data() + off, chunk);
+        if (n <= 0) {
+            return false;
+        }
+        off += n;
+    }
+    return true;
+#else
+    std::vector<struct iovec> iov(vecs.size());
+    for (size_t i = 0; i < vecs.size(); i++) {
+        iov[i].iov_base = const_cast<uint8_t*>(vecs[i].base);
+        iov[i].iov_len = vecs[i].len;
+    }
+
+    size_t idx = 0;
+    while (idx < iov.size()) {
+        int cnt = static_cast<int>(std::min<size_t>(iov.size() - idx, IOV_MAX));
+        ssize_t n = writev(fd, &iov[idx], cnt);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        // 处理部分写：跳过已写完的段，调整剩余段的起点
+        size_t written = static_cast<size_t>(n);
+        while (idx < iov.size() && written >= iov[idx].iov_len) {
+            written -= iov[idx].iov_len;
+            idx++;
+        }
+        if (idx < iov.size() && written > 0) {
+            iov[idx].iov_base = static_cast<uint8_t*>(iov[idx].iov_base) + written;
+            iov[idx].iov_len -= written;
+        }
+    }
+    return true;
+#endif
+}
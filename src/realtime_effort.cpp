@@ -0,0 +1,101 @@
+//
+// Created by Jianing on 2026/02/01.
+//
+#include "realtime_effort.h"
+#include <algorithm>
+#include <iostream>
+#include <string>
+
+std::vector<EncoderProfile> make_effort_levels(const EncoderProfile& base) {
+    std::vector<EncoderProfile> levels{base};
+
+    // 逐档追加的选项（后出现的同名选项覆盖配置里原有的值）
+    std::vector<const char*> steps;
+    if (base.codec == "mpeg4") {
+        steps = {
+            "mbd=simple:trellis=0",                               // 关掉率失真宏块决策和trellis
+            "mbd=simple:trellis=0:subq=2:me_range=8",             // 降低亚像素精化、缩小搜索范围
+            "mbd=simple:trellis=0:subq=1:motion_est=zero",        // 不做运动搜索，只用零向量
+        };
+    } else if (base.codec == "libx264") {
+        steps = {
+            "motion-est=hex:subq=4:trellis=0",
+            "motion-est=dia:subq=2:trellis=0:partitions=none",
+            "motion-est=dia:subq=1:trellis=0:partitions=none:mixed-refs=0:fast-pskip=1",
+        };
+    }
+
+    for (size_t i = 0; i < steps.size(); i++) {
+        EncoderProfile p = base;
+        p.name = base.name + "@" + std::to_string(i + 1);
+        p.options = base.options.empty() ? steps[i] : base.options + ":" + steps[i];
+        levels.push_back(p);
+    }
+    return levels;
+}
+
+EffortController::EffortController(const RealtimeOptions& opts, int level_count)
+        : opts(opts), level_count(std::max(level_count, 1)) {}
+
+void EffortController::on_frame(double src_seconds, uint32_t backlog, uint32_t capacity) {
+    auto now = std::chrono::steady_clock::now();
+    if (!started) {
+        started = true;
+        wall_start = now;
+        src_start = src_seconds;
+    }
+    // 落后 = 墙钟经过的时间 - 源时间经过的时间（负数表示快于实时）
+    double late = std::chrono::duration<double>(now - wall_start).count() - (src_seconds - src_start);
+    if (gop_frames == 0 || late > gop_late_peak) {
+        gop_late_peak = late;
+    }
+    gop_late_last = late;
+    worst_late = std::max(worst_late, late);
+    gop_backlog_sum += capacity > 0 ? static_cast<double>(backlog) / capacity : 0.0;
+    gop_frames++;
+}
+
+int EffortController::on_gop_boundary() {
+    if (gop_frames == 0) {
+        return current;
+    }
+    double backlog = gop_backlog_sum / gop_frames;
+    bool rising = gop_late_last > prev_gop_late;
+
+    int next = current;
+    const char* reason = "";
+    if (hold > 0) {
+        hold--;
+    } else if (current + 1 < level_count && gop_late_peak > opts.late_high && rising) {
+        // 已经在追回的欠账不再降档
+        next = current + 1;
+        reason = "落后超过阈值";
+    } else if (current + 1 < level_count && backlog >= opts.backlog_high && rising && gop_late_last > 0) {
+        next = current + 1;
+        reason = "输入积压且落后在增加";
+    } else if (current > 0 && gop_late_peak <= opts.late_low && (backlog <= opts.backlog_low || !rising)) {
+        next = current - 1;
+        reason = "负载下降";
+    }
+
+    if (opts.log_interval_gops > 0 && gop_index % opts.log_interval_gops == 0) {
+        std::cout << "[Realtime Info] GOP " << gop_index << "：落后 " << gop_late_last << "s（本GOP最大 "
+                  << gop_late_peak << "s），输入缓冲区平均占用 " << static_cast<int>(backlog * 100)
+                  << "%，档位 " << current << "\n";
+    }
+    if (next != current) {
+        std::cout << "[Realtime Info] " << reason << "（落后 " << gop_late_last << "s，最大 " << gop_late_peak
+                  << "s，缓冲区占用 " << static_cast<int>(backlog * 100) << "%）：编码档位 " << current << " -> "
+                  << next << "\n";
+        current = next;
+        hold = opts.hold_gops;
+        change_count++;
+    }
+
+    prev_gop_late = gop_late_last;
+    gop_frames = 0;
+    gop_late_peak = 0;
+    gop_backlog_sum = 0;
+    gop_index++;
+    return current;
+}
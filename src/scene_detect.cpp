@@ -0,0 +1,78 @@
+//
+// Created by Jianing on 2026/01/24.
+//
+#include "scene_detect.h"
+#include "pixfmt_kernels.h"
+#include <algorithm>
+
+SceneCutDetector::SceneCutDetector(const SceneCutOptions& options) : opts(options) {
+    opts.max_gop = std::max(opts.max_gop, 1);
+    opts.min_gop = std::max(std::min(opts.min_gop, opts.max_gop), 1);
+}
+
+bool SceneCutDetector::build_thumb(const AVFrame* frame) {
+    bool same_geometry = frame->width == src_w && frame->height == src_h;
+    if (!same_geometry) {
+        src_w = frame->width;
+        src_h = frame->height;
+        thumb_w = src_w / 4;
+        thumb_h = src_h / 4;
+        prev.clear();
+    }
+    cur.resize(static_cast<size_t>(thumb_w) * thumb_h);
+
+    const PixFmtKernels& k = pixfmt_kernels();
+    const int ls = frame->linesize[0];
+    for (int y = 0; y < thumb_h; y++) {
+        const uint8_t* r = frame->data[0] + static_cast<ptrdiff_t>(4 * y) * ls;
+        k.box4_row(r, r + ls, r + 2 * ls, r + 3 * ls, cur.data() + static_cast<size_t>(y) * thumb_w, thumb_w);
+    }
+    return same_geometry;
+}
+
+bool SceneCutDetector::next_keyframe(const AVFrame* frame) {
+    int64_t index = frame_index++;
+    bool key = false;
+
+    if (frame->width < 16 || frame->height < 16 || !frame->data[0]) {
+        // 画面太小不做检测，只按最长GOP
+        key = index == 0 || index - last_key >= opts.max_gop;
+        if (key && index > 0) gop_count++;
+    } else {
+        bool comparable = build_thumb(frame) && !prev.empty();
+        if (!comparable) {
+            key = true;  // 首帧或分辨率变化
+        } else {
+            const PixFmtKernels& k = pixfmt_kernels();
+            uint64_t sad = 0;
+            for (int y = 0; y < thumb_h; y++) {
+                size_t off = static_cast<size_t>(y) * thumb_w;
+                sad += k.sad_row(prev.data() + off, cur.data() + off, thumb_w);
+            }
+            double score = static_cast<double>(sad) / (static_cast<double>(thumb_w) * thumb_h);
+
+            bool cut = index - last_key >= opts.min_gop && score > opts.threshold &&
+                       (avg_score < 0 || score > opts.ratio * avg_score);
+            if (cut) {
+                key = true;
+                cut_count++;
+            } else if (index - last_key >= opts.max_gop) {
+                key = true;
+                gop_count++;
+            }
+            // 切换帧本身不计入平均，避免拉高新场景的判定基线
+            if (!cut) {
+                avg_score = avg_score < 0 ? score : 0.9 * avg_score + 0.1 * score;
+            } else {
+                avg_score = -1;
+            }
+        }
+        prev.swap(cur);
+    }
+
+    if (key) {
+        last_key = index;
+        keyframe_list.push_back(index);
+    }
+    return key;
+}
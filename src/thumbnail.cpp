@@ -0,0 +1,265 @@
+//
+// Created by Jianing on 2026/01/08.
+//
+#include "thumbnail.h"
+#include "json_util.h"
+#include "keyframe_sampler.h"
+#include <iostream>
+#include <fstream>
+#include <thread>
+#include <vector>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#include <libavutil/avutil.h>
+#include <libavutil/error.h>
+#include <libswscale/swscale.h>
+}
+
+namespace {
+
+struct Tile {
+    AVFrame* frame = nullptr;  // 解码出的关键帧（相邻时间点落在同一关键帧时共享）
+    double time = 0.0;         // 关键帧实际时间（秒）
+};
+
+// 把tiles中下标为 first, first+step, ... 的缩略图缩放到雪碧图对应位置
+void scale_tiles(const std::vector<Tile>& tiles, size_t first, size_t step,
+                 AVFrame* sheet, int columns, int tile_w, int tile_h) {
+    SwsContext* sws_ctx = nullptr;
+    for (size_t i = first; i < tiles.size(); i += step) {
+        const AVFrame* src = tiles[i].frame;
+        if (!src) continue;
+
+        sws_ctx = sws_getCachedContext(sws_ctx, src->width, src->height,
+                                       static_cast<AVPixelFormat>(src->format),
+                                       tile_w, tile_h, AV_PIX_FMT_YUVJ420P,
+                                       SWS_BILINEAR, nullptr, nullptr, nullptr);
+        if (!sws_ctx) {
+            std::cerr << "[Thumbnail Warn] 创建缩放上下文失败，跳过第" << i << "个缩略图\n";
+            continue;
+        }
+
+        int x = static_cast<int>(i % columns) * tile_w;
+        int y = static_cast<int>(i / columns) * tile_h;
+        uint8_t* dst[4] = {
+                sheet->data[0] + y * sheet->linesize[0] + x,
+                sheet->data[1] + (y / 2) * sheet->linesize[1] + x / 2,
+                sheet->data[2] + (y / 2) * sheet->linesize[2] + x / 2,
+                nullptr
+        };
+        sws_scale(sws_ctx, src->data, src->linesize, 0, src->height, dst, sheet->linesize);
+    }
+    sws_freeContext(sws_ctx);
+}
+
+bool encode_jpeg(AVFrame* sheet, const std::string& filename) {
+    const AVCodec* encoder = avcodec_find_encoder(AV_CODEC_ID_MJPEG);
+    if (!encoder) {
+        std::cerr << "[Thumbnail Error] 找不到MJPEG编码器\n";
+        return false;
+    }
+    AVCodecContext* enc_ctx = avcodec_alloc_context3(encoder);
+    if (!enc_ctx) {
+        return false;
+    }
+    enc_ctx->width = sheet->width;
+    enc_ctx->height = sheet->height;
+    enc_ctx->pix_fmt = AV_PIX_FMT_YUVJ420P;
+    enc_ctx->time_base = (AVRational){1, 25};
+    enc_ctx->flags |= AV_CODEC_FLAG_QSCALE;
+    enc_ctx->global_quality = FF_QP2LAMBDA * 3;
+
+    int ret = avcodec_open2(enc_ctx, encoder, nullptr);
+    if (ret < 0) {
+        char err_buf[1024];
+        av_strerror(ret, err_buf, sizeof(err_buf));
+        std::cerr << "[Thumbnail Error] 打开MJPEG编码器失败：" << err_buf << "\n";
+        avcodec_free_context(&enc_ctx);
+        return false;
+    }
+
+    sheet->pts = 0;
+    sheet->quality = enc_ctx->global_quality;
+    AVPacket* pkt = av_packet_alloc();
+    bool ok = false;
+    if (pkt && avcodec_send_frame(enc_ctx, sheet) >= 0) {
+        avcodec_send_frame(enc_ctx, nullptr);
+        if (avcodec_receive_packet(enc_ctx, pkt) >= 0) {
+            std::ofstream out(filename, std::ios::binary);
+            out.write(reinterpret_cast<const char*>(pkt->data), pkt->size);
+            ok = out.good();
+            av_packet_unref(pkt);
+        }
+    }
+    if (!ok) {
+        std::cerr << "[Thumbnail Error] 编码/写入雪碧图失败: " << filename << "\n";
+    }
+    av_packet_free(&pkt);
+    avcodec_free_context(&enc_ctx);
+    return ok;
+}
+
+bool write_tile_map(const std::string& filename, const ThumbnailOptions& opts,
+                    const std::vector<Tile>& tiles, int columns, int tile_w, int tile_h) {
+    std::ofstream out(filename);
+    if (!out.is_open()) {
+        std::cerr << "[Thumbnail Error] 无法打开映射文件: " << filename << "\n";
+        return false;
+    }
+    out << "{\n"
+        << "  \"sheet\": \"" << json_escape(opts.sheet_file) << "\",\n"
+        << "  \"tile_width\": " << tile_w << ",\n"
+        << "  \"tile_height\": " << tile_h << ",\n"
+        << "  \"columns\": " << columns << ",\n"
+        << "  \"tiles\": [\n";
+    for (size_t i = 0; i < tiles.size(); i++) {
+        out << "    {\"index\": " << i
+            << ", \"time\": " << tiles[i].time
+            << ", \"x\": " << (i % columns) * tile_w
+            << ", \"y\": " << (i / columns) * tile_h << "}"
+            << (i + 1 < tiles.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n}\n";
+    return out.good();
+}
+
+} // namespace
+
+bool generate_sprite_sheet(const char* input_file, const ThumbnailOptions& opts) {
+    if (opts.tile_count <= 0 || opts.tile_width <= 0) {
+        std::cerr << "[Thumbnail Error] 缩略图数量/宽度参数无效\n";
+        return false;
+    }
+
+    AVFormatContext* fmt_ctx = nullptr;
+    if (avformat_open_input(&fmt_ctx, input_file, nullptr, nullptr) < 0) {
+        std::cerr << "[Thumbnail Error] 打开输入文件失败: " << input_file << "\n";
+        return false;
+    }
+    if (avformat_find_stream_info(fmt_ctx, nullptr) < 0) {
+        std::cerr << "[Thumbnail Error] 获取媒体流信息失败\n";
+        avformat_close_input(&fmt_ctx);
+        return false;
+    }
+
+    AVCodec* decoder = nullptr;  // FFmpeg 4.4的av_find_best_stream要求非const
+    int stream_idx = av_find_best_stream(fmt_ctx, AVMEDIA_TYPE_VIDEO, -1, -1, &decoder, 0);
+    if (stream_idx < 0 || !decoder) {
+        std::cerr << "[Thumbnail Error] 未找到视频流\n";
+        avformat_close_input(&fmt_ctx);
+        return false;
+    }
+    AVStream* stream = fmt_ctx->streams[stream_idx];
+
+    AVCodecContext* dec_ctx = avcodec_alloc_context3(decoder);
+    if (!dec_ctx || avcodec_parameters_to_context(dec_ctx, stream->codecpar) < 0) {
+        std::cerr << "[Thumbnail Error] 初始化解码器上下文失败\n";
+        avcodec_free_context(&dec_ctx);
+        avformat_close_input(&fmt_ctx);
+        return false;
+    }
+    // 只解码关键帧；单帧解码不需要帧线程的流水延迟
+    dec_ctx->skip_frame = AVDISCARD_NONKEY;
+    dec_ctx->thread_type = FF_THREAD_SLICE;
+    if (avcodec_open2(dec_ctx, decoder, nullptr) < 0) {
+        std::cerr << "[Thumbnail Error] 打开视频解码器失败\n";
+        avcodec_free_context(&dec_ctx);
+        avformat_close_input(&fmt_ctx);
+        return false;
+    }
+
+    int64_t start = stream->start_time != AV_NOPTS_VALUE ? stream->start_time : 0;
+
+    std::vector<Tile> tiles(opts.tile_count);
+    AVFrame* frame = av_frame_alloc();
+    AVFrame* last_frame = nullptr;
+    int decoded = 0;
+
+    KeyframeSampler sampler(fmt_ctx, dec_ctx, stream_idx, start, stream_duration(fmt_ctx, stream), opts.tile_count);
+    for (int i = 0; frame && i < opts.tile_count; i++) {
+        KeyframeSample got = sampler.next(frame);
+        if (got == KeyframeSample::Failed) {
+            // seek失败或文件尾没有关键帧：沿用上一张
+            if (last_frame) {
+                tiles[i].frame = av_frame_clone(last_frame);
+                tiles[i].time = tiles[i > 0 ? i - 1 : 0].time;
+            }
+            continue;
+        }
+
+        if (got == KeyframeSample::Repeated && last_frame) {
+            // 多个时间点落在同一GOP，复用已解码的关键帧
+            tiles[i].frame = av_frame_clone(last_frame);
+            av_frame_unref(frame);
+        } else {
+            tiles[i].frame = av_frame_clone(frame);
+            av_frame_unref(frame);
+            last_frame = tiles[i].frame;
+            decoded++;
+        }
+        if (sampler.key_pts() != AV_NOPTS_VALUE) {
+            tiles[i].time = (sampler.key_pts() - start) * av_q2d(stream->time_base);
+        }
+    }
+    av_frame_free(&frame);
+
+    // 缩略图尺寸：宽度固定，高度按显示宽高比，两者取偶数以适配YUV420
+    int src_w = stream->codecpar->width;
+    int src_h = stream->codecpar->height;
+    AVRational sar = stream->codecpar->sample_aspect_ratio;
+    double display_aspect = static_cast<double>(src_w) / std::max(src_h, 1);
+    if (sar.num > 0 && sar.den > 0) {
+        display_aspect *= av_q2d(sar);
+    }
+    int tile_w = opts.tile_width & ~1;
+    int tile_h = std::max(2, static_cast<int>(std::lround(tile_w / display_aspect)) & ~1);
+    int columns = opts.columns > 0 ? opts.columns
+                                   : static_cast<int>(std::ceil(std::sqrt(static_cast<double>(opts.tile_count))));
+    int rows = (opts.tile_count + columns - 1) / columns;
+
+    AVFrame* sheet = av_frame_alloc();
+    sheet->format = AV_PIX_FMT_YUVJ420P;
+    sheet->width = columns * tile_w;
+    sheet->height = rows * tile_h;
+    bool ok = av_frame_get_buffer(sheet, 0) >= 0;
+    if (ok) {
+        // 全范围YUV黑底（末行不满时的空位）
+        memset(sheet->data[0], 0, sheet->linesize[0] * sheet->height);
+        memset(sheet->data[1], 128, sheet->linesize[1] * (sheet->height / 2));
+        memset(sheet->data[2], 128, sheet->linesize[2] * (sheet->height / 2));
+
+        int thread_num = std::max(1, std::min(opts.threads, opts.tile_count));
+        std::vector<std::thread> workers;
+        for (int t = 0; t < thread_num; t++) {
+            workers.emplace_back(scale_tiles, std::cref(tiles), static_cast<size_t>(t),
+                                 static_cast<size_t>(thread_num), sheet, columns, tile_w, tile_h);
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+
+        ok = encode_jpeg(sheet, opts.sheet_file) &&
+             write_tile_map(opts.map_file, opts, tiles, columns, tile_w, tile_h);
+    } else {
+        std::cerr << "[Thumbnail Error] 分配雪碧图缓冲区失败\n";
+    }
+
+    if (ok) {
+        std::cout << "[Thumbnail Info] 雪碧图生成完成: " << opts.sheet_file
+                  << "（" << columns << "x" << rows << "，解码关键帧" << decoded
+                  << "个，映射: " << opts.map_file << "）\n";
+    }
+
+    av_frame_free(&sheet);
+    for (auto& tile : tiles) {
+        av_frame_free(&tile.frame);
+    }
+    avcodec_free_context(&dec_ctx);
+    avformat_close_input(&fmt_ctx);
+    return ok;
+}
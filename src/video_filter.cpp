@@ -0,0 +1,246 @@
+//
+// Created by Jianing on 2026/01/22.
+//
+#include "video_filter.h"
+#include "job_stats.h"
+#include <iostream>
+#include <chrono>
+#include <cstring>
+
+extern "C" {
+#include <libavfilter/avfilter.h>
+#include <libavfilter/buffersrc.h>
+#include <libavfilter/buffersink.h>
+#include <libavutil/pixdesc.h>
+}
+
+VideoFilter::VideoFilter(const VideoFilterOptions& options) : opts(options) {}
+
+VideoFilter::~VideoFilter() {
+    free_graph();
+}
+
+void VideoFilter::free_graph() {
+    if (graph) {
+        report_stats();
+    }
+    avfilter_graph_free(&graph);
+    src_ctx = nullptr;
+    sink_ctx = nullptr;
+}
+
+bool VideoFilter::configure(int width, int height, AVPixelFormat pix_fmt, AVRational sar) {
+    free_graph();
+
+    graph = avfilter_graph_alloc();
+    if (!graph) {
+        return false;
+    }
+    // 必须在创建滤镜前设置：首个滤镜创建时按此初始化滤镜图线程池
+    graph->nb_threads = opts.threads;
+
+    char args[512];
+    snprintf(args, sizeof(args), "video_size=%dx%d:pix_fmt=%d:time_base=%d/%d:pixel_aspect=%d/%d",
+             width, height, pix_fmt, opts.time_base.num, opts.time_base.den,
+             sar.num > 0 ? sar.num : 0, sar.den > 0 ? sar.den : 1);
+    if (opts.frame_rate.num > 0 && opts.frame_rate.den > 0) {
+        size_t len = strlen(args);
+        snprintf(args + len, sizeof(args) - len, ":frame_rate=%d/%d", opts.frame_rate.num, opts.frame_rate.den);
+    }
+
+    AVFilterInOut* outputs = avfilter_inout_alloc();
+    AVFilterInOut* inputs = avfilter_inout_alloc();
+    int ret = outputs && inputs ? 0 : AVERROR(ENOMEM);
+    if (ret >= 0) {
+        ret = avfilter_graph_create_filter(&src_ctx, avfilter_get_by_name("buffer"), "in", args, nullptr, graph);
+    }
+    if (ret >= 0) {
+        ret = avfilter_graph_create_filter(&sink_ctx, avfilter_get_by_name("buffersink"), "out", nullptr, nullptr,
+                                           graph);
+    }
+    if (ret >= 0) {
+        // 用户滤镜链的输入接buffer，输出接buffersink
+        outputs->name = av_strdup("in");
+        outputs->filter_ctx = src_ctx;
+        outputs->pad_idx = 0;
+        outputs->next = nullptr;
+        inputs->name = av_strdup("out");
+        inputs->filter_ctx = sink_ctx;
+        inputs->pad_idx = 0;
+        inputs->next = nullptr;
+        ret = avfilter_graph_parse_ptr(graph, opts.graph.c_str(), &inputs, &outputs, nullptr);
+    }
+    if (ret >= 0) {
+        ret = avfilter_graph_config(graph, nullptr);
+    }
+    avfilter_inout_free(&inputs);
+    avfilter_inout_free(&outputs);
+
+    if (ret < 0) {
+        char err_buf[1024];
+        av_strerror(ret, err_buf, sizeof(err_buf));
+        std::cerr << "[VideoFilter Error] 建立滤镜图失败（" << opts.graph << "）：" << err_buf << "\n";
+        avfilter_graph_free(&graph);
+        src_ctx = nullptr;
+        sink_ctx = nullptr;
+        return false;
+    }
+
+    in_w = width;
+    in_h = height;
+    in_fmt = pix_fmt;
+
+    // 【一次性信息】每次建图输出一次
+    std::cout << "[VideoFilter Info] 滤镜图 \"" << opts.graph << "\"：" << width << "x" << height << " "
+              << av_get_pix_fmt_name(pix_fmt) << " → " << output_width() << "x" << output_height() << " "
+              << av_get_pix_fmt_name(output_format()) << "（" << opts.threads << "线程）\n";
+    return true;
+}
+
+bool VideoFilter::matches(const AVFrame* frame) const {
+    return graph && frame->width == in_w && frame->height == in_h && frame->format == in_fmt;
+}
+
+int VideoFilter::output_width() const {
+    return sink_ctx ? av_buffersink_get_w(sink_ctx) : 0;
+}
+
+int VideoFilter::output_height() const {
+    return sink_ctx ? av_buffersink_get_h(sink_ctx) : 0;
+}
+
+AVPixelFormat VideoFilter::output_format() const {
+    return sink_ctx ? static_cast<AVPixelFormat>(av_buffersink_get_format(sink_ctx)) : AV_PIX_FMT_NONE;
+}
+
+AVRational VideoFilter::output_time_base() const {
+    return sink_ctx ? av_buffersink_get_time_base(sink_ctx) : opts.time_base;
+}
+
+AVRational VideoFilter::output_frame_rate() const {
+    return sink_ctx ? av_buffersink_get_frame_rate(sink_ctx) : opts.frame_rate;
+}
+
+int VideoFilter::send(const AVFrame* frame) {
+    if (!src_ctx) {
+        return AVERROR(EINVAL);
+    }
+    auto start = std::chrono::steady_clock::now();
+    // KEEP_REF：滤镜图另建引用，调用者的帧（可能还被其他阶段共享）保持不变
+    int ret = av_buffersrc_add_frame_flags(src_ctx, const_cast<AVFrame*>(frame), AV_BUFFERSRC_FLAG_KEEP_REF);
+    g_job_stats.add_time("filter.send", std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    return ret;
+}
+
+int VideoFilter::receive(AVFrame* frame) {
+    if (!sink_ctx) {
+        return AVERROR(EINVAL);
+    }
+    // 滤镜实际在拉取输出时执行，这里的耗时即整条滤镜链的处理时间
+    auto start = std::chrono::steady_clock::now();
+    int ret = av_buffersink_get_frame(sink_ctx, frame);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    g_job_stats.add_time("filter.receive", seconds, ret >= 0 ? 1 : 0);
+    return ret;
+}
+
+void VideoFilter::report_stats() {
+    // libavfilter不公开单个滤镜的耗时，这里按滤镜实例记录输入/输出帧数，
+    // 耗时在send/receive处按整条链统计
+    for (unsigned i = 0; graph && i < graph->nb_filters; i++) {
+        const AVFilterContext* f = graph->filters[i];
+        if (f == src_ctx || f == sink_ctx) {
+            continue;
+        }
+        std::string key = std::string("filter.") + f->name;
+        if (f->nb_inputs > 0 && f->inputs[0]) {
+            g_job_stats.add_count(key + ".in_frames", f->inputs[0]->frame_count_out);
+        }
+        if (f->nb_outputs > 0 && f->outputs[0]) {
+            g_job_stats.add_count(key + ".out_frames", f->outputs[0]->frame_count_in);
+        }
+    }
+}
+
+namespace {
+
+// 从滤镜图取出所有可用帧推入out；out已关闭返回false
+bool drain_filter(VideoFilter* filter, AVFrame* frame, RingBuffer<AVFrame*>* out, int* frame_count) {
+    while (true) {
+        int ret = filter->receive(frame);
+        if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
+            return true;
+        }
+        if (ret < 0) {
+            char err_buf[1024];
+            av_strerror(ret, err_buf, sizeof(err_buf));
+            std::cerr << "[VideoFilter Warn] 取滤镜输出失败：" << err_buf << "\n";
+            return true;
+        }
+        (*frame_count)++;
+        bool pushed = out->push(frame);
+        av_frame_unref(frame);
+        if (!pushed) {
+            return false;
+        }
+    }
+}
+
+} // namespace
+
+void video_filter_thread(VideoFilter* filter, RingBuffer<AVFrame*>* in, RingBuffer<AVFrame*>* out) {
+    std::cout << "start videoFilter!\n";
+    AVFrame* src = av_frame_alloc();
+    AVFrame* dst = av_frame_alloc();
+    int frame_count = 0;
+    bool running = true;
+
+    while (running && in->pop(src)) {
+        if (!filter->matches(src)) {
+            // 输入几何变化（或尚未建图）：冲刷旧图后按当前帧重建
+            if (filter->is_configured()) {
+                filter->send(nullptr);
+                running = drain_filter(filter, dst, out, &frame_count);
+            }
+            if (!running || !filter->configure(src->width, src->height, static_cast<AVPixelFormat>(src->format),
+                                               src->sample_aspect_ratio)) {
+                av_frame_unref(src);
+                running = false;
+                break;
+            }
+        }
+
+        int ret = filter->send(src);
+        av_frame_unref(src);
+        if (ret < 0) {
+            char err_buf[1024];
+            av_strerror(ret, err_buf, sizeof(err_buf));
+            std::cerr << "[VideoFilter Warn] 送入滤镜图失败：" << err_buf << "\n";
+            continue;
+        }
+        running = drain_filter(filter, dst, out, &frame_count);
+    }
+
+    // 冲刷滤镜图中缓存的帧（如yadif的最后一帧）
+    if (running && filter->is_configured() && filter->send(nullptr) >= 0) {
+        drain_filter(filter, dst, out, &frame_count);
+    }
+
+    out->flush();
+
+    // 出错提前结束：下游已收到结束信号，但上游还会往输入缓冲区推帧，继续取出丢弃直到上游结束，
+    // 否则解码线程阻塞在满的缓冲区上，整个任务卡死
+    if (!running) {
+        std::cerr << "[VideoFilter Error] 滤镜阶段提前结束（建图失败或下游已停止），丢弃剩余输入帧直到上游结束\n";
+        int64_t discarded = 0;
+        while (in->pop(src)) {
+            av_frame_unref(src);
+            discarded++;
+        }
+        std::cerr << "[VideoFilter Error] 共丢弃 " << discarded << " 帧\n";
+    }
+
+    av_frame_free(&src);
+    av_frame_free(&dst);
+    std::cout << "[VideoFilter Info] 滤镜线程退出，共输出 " << frame_count << " 帧\n";
+}
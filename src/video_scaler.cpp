@@ -0,0 +1,370 @@
+//
+// Created by Jianing on 2026/01/15.
+//
+#include "video_scaler.h"
+#include "pixfmt_convert.h"
+#include "box_downscale.h"
+#include <iostream>
+#include <algorithm>
+#include <numeric>
+
+extern "C" {
+#include <libavutil/imgutils.h>
+#include <libavutil/pixdesc.h>
+}
+
+namespace {
+
+// 平面p中与亮度行y对应的行号
+int plane_row(const AVPixFmtDescriptor* desc, int p, int y) {
+    return (p == 1 || p == 2) ? (y >> desc->log2_chroma_h) : y;
+}
+
+// 取frame从亮度行y开始的各平面指针
+void offset_planes(const AVFrame* frame, const AVPixFmtDescriptor* desc, int y, uint8_t* out[4]) {
+    for (int p = 0; p < 4; p++) {
+        out[p] = frame->data[p] ? frame->data[p] + plane_row(desc, p, y) * frame->linesize[p] : nullptr;
+    }
+}
+
+// YUVJ格式：swscale按全范围读入，输出非J的YUV格式时默认转为有限范围
+bool is_yuvj(int fmt) {
+    return fmt == AV_PIX_FMT_YUVJ420P || fmt == AV_PIX_FMT_YUVJ422P || fmt == AV_PIX_FMT_YUVJ444P ||
+           fmt == AV_PIX_FMT_YUVJ440P || fmt == AV_PIX_FMT_YUVJ411P;
+}
+
+// 输出保持全范围（与盒式缩小、SIMD格式转换一致，帧标记AVCOL_RANGE_JPEG）
+void keep_full_range(SwsContext* sws) {
+    int* inv_table = nullptr;
+    int* table = nullptr;
+    int src_range = 0, dst_range = 0, brightness = 0, contrast = 0, saturation = 0;
+    if (sws_getColorspaceDetails(sws, &inv_table, &src_range, &table, &dst_range,
+                                 &brightness, &contrast, &saturation) >= 0) {
+        sws_setColorspaceDetails(sws, inv_table, 1, table, 1, brightness, contrast, saturation);
+    }
+}
+
+} // namespace
+
+void scale_output_size(const ScaleOptions& opts, int src_w, int src_h, int* dst_w, int* dst_h) {
+    int w = opts.width;
+    int h = opts.height;
+    if (w <= 0 && h <= 0) {
+        w = src_w;
+        h = src_h;
+    } else if (h <= 0) {
+        h = static_cast<int>(av_rescale(w, src_h, src_w));
+    } else if (w <= 0) {
+        w = static_cast<int>(av_rescale(h, src_w, src_h));
+    }
+    *dst_w = std::max(2, w & ~1);
+    *dst_h = std::max(2, h & ~1);
+}
+
+// ====================== SliceWorkers ======================
+
+SliceWorkers::SliceWorkers(int threads) {
+    // 调用线程本身承担第0个任务，只需额外创建threads-1个线程
+    for (int i = 1; i < std::max(threads, 1); i++) {
+        workers.emplace_back(&SliceWorkers::worker_loop, this, i);
+    }
+}
+
+SliceWorkers::~SliceWorkers() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        quit = true;
+    }
+    start_cv.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void SliceWorkers::run(int n, const std::function<void(int)>& fn) {
+    n = std::min(n, size());
+    if (n <= 1) {
+        if (n == 1) fn(0);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        job = &fn;
+        job_count = n;
+        pending = static_cast<int>(workers.size());
+        generation++;
+    }
+    start_cv.notify_all();
+
+    fn(0);
+
+    std::unique_lock<std::mutex> lock(mtx);
+    done_cv.wait(lock, [this]() { return pending == 0; });
+    job = nullptr;
+}
+
+void SliceWorkers::worker_loop(int index) {
+    uint64_t seen = 0;
+    while (true) {
+        const std::function<void(int)>* fn;
+        int count;
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            start_cv.wait(lock, [&]() { return quit || generation != seen; });
+            if (quit) return;
+            seen = generation;
+            fn = job;
+            count = job_count;
+        }
+
+        if (index < count) {
+            (*fn)(index);
+        }
+
+        std::lock_guard<std::mutex> lock(mtx);
+        if (--pending == 0) {
+            done_cv.notify_one();
+        }
+    }
+}
+
+// ====================== VideoScaler ======================
+
+VideoScaler::VideoScaler(const ScaleOptions& options)
+        : opts(options), workers(options.threads) {}
+
+VideoScaler::~VideoScaler() {
+    for (auto& item : cache) {
+        free_geometry(item.second);
+    }
+}
+
+void VideoScaler::free_geometry(Geometry* geo) {
+    for (auto& band : geo->bands) {
+        sws_freeContext(band.sws);
+        av_frame_free(&band.scratch);
+    }
+    delete geo;
+}
+
+bool VideoScaler::plan_bands(Geometry* geo, int src_w, int src_h, AVPixelFormat src_fmt) {
+    const AVPixFmtDescriptor* src_desc = av_pix_fmt_desc_get(src_fmt);
+    const AVPixFmtDescriptor* dst_desc = av_pix_fmt_desc_get(opts.pix_fmt);
+    if (!src_desc || !dst_desc) {
+        return false;
+    }
+    int dst_w = geo->dst_w;
+    int dst_h = geo->dst_h;
+
+    // 带边界必须同时落在源/目标的整数行上且比例与整帧完全一致，这样每个带的
+    // 滤波相位与整帧缩放相同；同时满足两侧色度下采样的行对齐
+    int g = std::gcd(src_h, dst_h);
+    int unit_s = src_h / g;
+    int unit_d = dst_h / g;
+    int sub = 1 << std::max(src_desc->log2_chroma_h, dst_desc->log2_chroma_h);
+    int k = 1;
+    while ((unit_s * k) % sub || (unit_d * k) % sub) {
+        k++;
+    }
+    unit_s *= k;
+    unit_d *= k;
+    int units = dst_h / unit_d;
+
+    // 上下余量（源行）覆盖纵向滤波器支撑范围，余量内的输出行在带内丢弃
+    int ratio = (src_h + dst_h - 1) / dst_h;
+    int margin_units = (4 * ratio + 8 + unit_s - 1) / unit_s;
+
+    int band_count = std::min(workers.size(), units);
+    // 带太少（几何不可切分）或余量比带本身还大时，切片得不偿失
+    if (band_count > 1 && units / band_count < margin_units) {
+        band_count = std::max(1, units / std::max(margin_units, 1));
+    }
+    band_count = std::max(band_count, 1);
+
+    for (int b = 0; b < band_count; b++) {
+        Band band;
+        int u0 = units * b / band_count;
+        int u1 = units * (b + 1) / band_count;
+        int e0 = band_count > 1 ? std::max(0, u0 - margin_units) : 0;
+        int e1 = band_count > 1 ? std::min(units, u1 + margin_units) : units;
+
+        band.src_y = e0 * unit_s;
+        band.src_h = (e1 - e0) * unit_s;
+        band.ext_y = e0 * unit_d;
+        band.ext_h = (e1 - e0) * unit_d;
+        band.out_y = u0 * unit_d;
+        band.out_h = (u1 - u0) * unit_d;
+        if (band_count == 1) {
+            band.src_h = src_h;
+            band.ext_h = band.out_h = dst_h;
+        }
+
+        band.sws = sws_getContext(src_w, band.src_h, src_fmt, dst_w, band.ext_h, opts.pix_fmt,
+                                  opts.sws_flags, nullptr, nullptr, nullptr);
+        if (!band.sws) {
+            geo->bands.push_back(band);
+            return false;
+        }
+        if (is_yuvj(src_fmt) && !(av_pix_fmt_desc_get(opts.pix_fmt)->flags & AV_PIX_FMT_FLAG_RGB)) {
+            keep_full_range(band.sws);
+        }
+        if (band_count > 1) {
+            band.scratch = av_frame_alloc();
+            band.scratch->format = opts.pix_fmt;
+            band.scratch->width = dst_w;
+            band.scratch->height = band.ext_h;
+            if (av_frame_get_buffer(band.scratch, 0) < 0) {
+                geo->bands.push_back(band);
+                return false;
+            }
+        }
+        geo->bands.push_back(band);
+    }
+    return true;
+}
+
+VideoScaler::Geometry* VideoScaler::get_geometry(const AVFrame* src) {
+    GeometryKey key(src->width, src->height, src->format);
+    auto it = cache.find(key);
+    if (it != cache.end()) {
+        return it->second;
+    }
+
+    Geometry* geo = new Geometry();
+    scale_output_size(opts, src->width, src->height, &geo->dst_w, &geo->dst_h);
+
+    bool same_size = geo->dst_w == src->width && geo->dst_h == src->height;
+    bool passthrough = same_size && src->format == opts.pix_fmt;
+    geo->fast_convert = same_size && !passthrough && opts.pix_fmt == AV_PIX_FMT_YUV420P &&
+                        can_convert_to_yuv420p(static_cast<AVPixelFormat>(src->format));
+    bool is_420 = src->format == AV_PIX_FMT_YUV420P || src->format == AV_PIX_FMT_YUVJ420P;
+    if (opts.box_fast_path && opts.pix_fmt == AV_PIX_FMT_YUV420P && is_420) {
+        geo->box_factor = box_downscale_factor(src->width, src->height, geo->dst_w, geo->dst_h);
+    }
+    if (!passthrough && !geo->fast_convert && !geo->box_factor && !plan_bands(geo, src->width, src->height, static_cast<AVPixelFormat>(src->format))) {
+        std::cerr << "[VideoScaler Error] 创建缩放上下文失败: " << src->width << "x" << src->height
+                  << " " << av_get_pix_fmt_name(static_cast<AVPixelFormat>(src->format)) << "\n";
+        free_geometry(geo);
+        return nullptr;
+    }
+
+    // 【一次性信息】每种源几何输出一次
+    std::cout << "[VideoScaler Info] " << src->width << "x" << src->height << " "
+              << av_get_pix_fmt_name(static_cast<AVPixelFormat>(src->format)) << " → "
+              << geo->dst_w << "x" << geo->dst_h << " " << av_get_pix_fmt_name(opts.pix_fmt)
+              << (passthrough ? "（直通）" : geo->fast_convert ? "（SIMD格式转换）"
+                  : geo->box_factor ? "（" + std::to_string(geo->box_factor) + ":1盒式缩小）"
+                  : "（" + std::to_string(geo->bands.size()) + "个切片并行）") << "\n";
+    cache[key] = geo;
+    return geo;
+}
+
+void VideoScaler::scale_band(const Band& band, const AVFrame* src, AVFrame* dst) const {
+    const AVPixFmtDescriptor* src_desc = av_pix_fmt_desc_get(static_cast<AVPixelFormat>(src->format));
+    const AVPixFmtDescriptor* dst_desc = av_pix_fmt_desc_get(opts.pix_fmt);
+
+    uint8_t* src_planes[4];
+    offset_planes(src, src_desc, band.src_y, src_planes);
+
+    if (!band.scratch) {
+        sws_scale(band.sws, src_planes, src->linesize, 0, band.src_h, dst->data, dst->linesize);
+        return;
+    }
+
+    sws_scale(band.sws, src_planes, src->linesize, 0, band.src_h, band.scratch->data, band.scratch->linesize);
+
+    // 只把带内有效行拷到输出帧，余量行丢弃
+    int bytewidth[4] = {0};
+    av_image_fill_linesizes(bytewidth, opts.pix_fmt, dst->width);
+    uint8_t* from[4];
+    uint8_t* to[4];
+    offset_planes(band.scratch, dst_desc, band.out_y - band.ext_y, from);
+    offset_planes(dst, dst_desc, band.out_y, to);
+    for (int p = 0; p < 4 && to[p]; p++) {
+        av_image_copy_plane(to[p], dst->linesize[p], from[p], band.scratch->linesize[p],
+                            bytewidth[p], plane_row(dst_desc, p, band.out_h));
+    }
+}
+
+int VideoScaler::scale(const AVFrame* src, AVFrame* dst) {
+    Geometry* geo = get_geometry(src);
+    if (!geo) {
+        return AVERROR(EINVAL);
+    }
+    if (geo->fast_convert) {
+        return convert_to_yuv420p(src, dst, &pool);
+    }
+    if (geo->bands.empty() && !geo->box_factor) {
+        return av_frame_ref(dst, src);
+    }
+
+    dst->format = opts.pix_fmt;
+    dst->width = geo->dst_w;
+    dst->height = geo->dst_h;
+    int ret = pool.get_buffer(dst);
+    if (ret < 0) {
+        return ret;
+    }
+    av_frame_copy_props(dst, src);
+
+    if (geo->box_factor) {
+        box_downscale_yuv420p(src, dst, geo->box_factor, &workers);
+        if (src->format == AV_PIX_FMT_YUVJ420P) {
+            dst->color_range = AVCOL_RANGE_JPEG;
+        }
+        return 0;
+    }
+
+    workers.run(static_cast<int>(geo->bands.size()), [&](int i) {
+        scale_band(geo->bands[i], src, dst);
+    });
+    if (is_yuvj(src->format)) {
+        dst->color_range = AVCOL_RANGE_JPEG;
+    }
+    return 0;
+}
+
+namespace {
+
+// 缩放线程主循环：pop_fn取输入帧（结束时返回false）
+template <typename PopFn>
+void scale_loop(const ScaleOptions& opts, PopFn pop_fn, RingBuffer<AVFrame*>* out) {
+    std::cout << "start videoScale!\n";
+    VideoScaler scaler(opts);
+    AVFrame* src = av_frame_alloc();
+    AVFrame* dst = av_frame_alloc();
+    int frame_count = 0;
+
+    while (pop_fn(src)) {
+        int ret = scaler.scale(src, dst);
+        av_frame_unref(src);
+        if (ret < 0) {
+            std::cerr << "[VideoScaler Warn] 第" << frame_count + 1 << "帧缩放失败，跳过\n";
+            continue;
+        }
+        frame_count++;
+        bool pushed = out->push(dst);
+        av_frame_unref(dst);
+        if (!pushed) {
+            break;
+        }
+    }
+
+    out->flush();
+    av_frame_free(&src);
+    av_frame_free(&dst);
+    std::cout << "[VideoScaler Info] 缩放线程退出，共处理 " << frame_count << " 帧\n";
+}
+
+} // namespace
+
+void video_scale_thread(ScaleOptions opts, RingBuffer<AVFrame*>* in, RingBuffer<AVFrame*>* out) {
+    scale_loop(opts, [in](AVFrame* frame) { return in->pop(frame); }, out);
+}
+
+void video_scale_thread_broadcast(ScaleOptions opts, BroadcastFrameRing* in, int consumer_id,
+                                  RingBuffer<AVFrame*>* out) {
+    scale_loop(opts, [in, consumer_id](AVFrame* frame) { return in->pop(consumer_id, frame); }, out);
+    // 下游提前退出时不再占用广播环槽位
+    in->remove_consumer(consumer_id);
+}
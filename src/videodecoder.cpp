@@ -3,165 +3,613 @@
 //
 #include "videodecoder.h"
 #include "ring_buffer.h"
+#include "frame_pool.h"
+#include "raw_frame_writer.h"
+#include "job_stats.h"
 #include <iostream>
-#include <fstream>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <vector>
 
 extern "C" {
 #include <libavformat/avformat.h>
 #include <libavcodec/avcodec.h>
 #include <libavutil/avutil.h>
 #include <libavutil/imgutils.h>
+#include <libavcodec/codec_desc.h>
 }
 
 // ============ YUV输出开关 ============
+// 解码帧交给独立写线程导出为原始YUV，不阻塞解码
 #define ENABLE_YUV_OUTPUT 0
+// 1：带YUV4MPEG2头的.y4m；0：裸.yuv
+#define YUV_OUTPUT_Y4M 1
 // ====================================
 
-#if ENABLE_YUV_OUTPUT
-class YUVFileWriter {
+// ============ 帧缓冲池开关 ============
+// 解码器使用自定义get_buffer2，从按分辨率/格式划分的AVBufferPool分配帧
+#define ENABLE_FRAME_POOL 1
+// 大页模式：HugePageMode::None / Transparent / HugeTLB
+#define FRAME_POOL_HUGE_PAGE HugePageMode::None
+// ====================================
+
+
+// 抽帧器：按目标帧率决定每个Packet的丢弃级别，以及解码出的帧是否保留
+class FrameDecimator {
 private:
-    std::ofstream yuv_file;
-    int frame_count = 0;
+    bool enabled = false;
+    AVRational time_base = {0, 1};
+    AVRational target_fps = {0, 1};
+    int64_t frame_dur = 0;                  // 源帧间隔（流时间基）
+    int64_t start_pts = AV_NOPTS_VALUE;     // 第一个保留时刻
+    int64_t keep_index = 0;                 // 下一个保留时刻的序号
+    int64_t next_keep_pts = AV_NOPTS_VALUE; // 下一个需要输出的时刻
+    std::vector<int64_t> keyframes;         // 解封装器的关键帧索引（可能是dts）
+    int64_t reorder_span = 0;               // 关键帧pts可能比索引时间戳晚的量（重排深度）
+    int64_t next_key_ts = AV_NOPTS_VALUE;   // 索引中当前GOP之后的关键帧，未知为AV_NOPTS_VALUE
+    bool skipping_gop = false;              // 当前GOP剩余部分整体丢弃
 
 public:
-    bool open(const std::string& filename) {
-        yuv_file.open(filename, std::ios::binary);
-        if (!yuv_file.is_open()) {
-            std::cerr << "[Error] 无法打开YUV输出文件: " << filename << "\n";
+    int64_t dropped_pkts = 0;   // 未送入解码器的Packet数
+    int64_t dropped_frames = 0; // 解码后丢弃的帧数
+
+    void init(const VideoDecodeOptions& opts, const AVCodecParameters* codec_par) {
+        enabled = opts.target_fps.num > 0 && opts.target_fps.den > 0 &&
+                  opts.time_base.num > 0 && opts.time_base.den > 0;
+        if (!enabled) return;
+        time_base = opts.time_base;
+        target_fps = opts.target_fps;
+        if (opts.frame_rate.num > 0 && opts.frame_rate.den > 0) {
+            frame_dur = av_rescale_q(1, av_inv_q(opts.frame_rate), time_base);
+        }
+        keyframes = opts.keyframe_index;
+        reorder_span = static_cast<int64_t>(codec_par->video_delay) * frame_dur;
+        std::cout << "[VideoDecoder Info] 抽帧模式：目标帧率 "
+                  << target_fps.num << "/" << target_fps.den << "（关键帧索引 " << keyframes.size() << " 条）\n";
+    }
+
+    bool is_enabled() const { return enabled; }
+
+    // 返回false表示该Packet不需要送入解码器；否则设置本Packet的skip_frame
+    bool on_packet(AVCodecContext* codec_ctx, const AVPacket& pkt) {
+        if (!enabled || pkt.pts == AV_NOPTS_VALUE) {
+            return true;
+        }
+
+        if (pkt.flags & AV_PKT_FLAG_KEY) {
+            auto next = std::upper_bound(keyframes.begin(), keyframes.end(), pkt.pts);
+            next_key_ts = next != keyframes.end() ? *next : AV_NOPTS_VALUE;
+            skipping_gop = false;
+            if (start_pts == AV_NOPTS_VALUE) {
+                start_pts = pkt.pts;
+                next_keep_pts = start_pts;
+            }
+        }
+        if (start_pts == AV_NOPTS_VALUE || skipping_gop) {
+            // 首个关键帧之前的Packet无法独立解码；GOP已放弃时一直丢到下一个关键帧
+            dropped_pkts++;
             return false;
         }
-        // 【一次性信息】保留
-        std::cout << "[Info] YUV文件已打开: " << filename << "\n";
+
+        // 索引表明下一个关键帧（加上重排余量）不晚于下一个保留时刻：本GOP的帧都早于它，后续Packet都不被依赖。
+        // GOP长度不固定（场景切换、最小/最大关键帧间隔），没有索引时不能按上一GOP推测，只跳过非参考帧
+        if (next_key_ts != AV_NOPTS_VALUE && next_key_ts + reorder_span <= next_keep_pts - frame_dur / 2) {
+            skipping_gop = true;
+            dropped_pkts++;
+            return false;
+        }
+
+        int64_t lead = next_keep_pts - pkt.pts;
+        if (lead <= frame_dur / 2) {
+            codec_ctx->skip_frame = AVDISCARD_DEFAULT;
+        } else if (pkt.flags & AV_PKT_FLAG_DISPOSABLE) {
+            // 非参考帧且早于目标时刻：没有帧依赖它
+            dropped_pkts++;
+            return false;
+        } else {
+            // 目标时刻之前只需要参考帧
+            codec_ctx->skip_frame = AVDISCARD_NONREF;
+        }
         return true;
     }
 
-    void write_frame(AVFrame* frame) {
-        if (!yuv_file.is_open() || !frame || !frame->data[0]) {
-            return;
+    // 返回true表示该帧需要输出
+    bool on_frame(const AVFrame* frame) {
+        if (!enabled) return true;
+        if (!keep_pts(frame->best_effort_timestamp)) {
+            dropped_frames++;
+            return false;
         }
+        return true;
+    }
 
-        int width = frame->width;
-        int height = frame->height;
+    // 帧内编码流：每个Packet就是一帧且按显示顺序到达，直接按pts决定是否需要解码
+    bool on_intra_packet(const AVPacket& pkt) {
+        if (!enabled || pkt.pts == AV_NOPTS_VALUE) {
+            return true;
+        }
+        if (start_pts == AV_NOPTS_VALUE) {
+            start_pts = pkt.pts;
+            next_keep_pts = start_pts;
+        }
+        if (!keep_pts(pkt.pts)) {
+            dropped_pkts++;
+            return false;
+        }
+        return true;
+    }
 
-        // 写入Y分量
-        for (int i = 0; i < height; i++) {
-            yuv_file.write(reinterpret_cast<char*>(frame->data[0] + i * frame->linesize[0]), width);
+private:
+    // 时刻pts的帧是否保留；保留时推进到下一个保留时刻
+    bool keep_pts(int64_t pts) {
+        if (pts == AV_NOPTS_VALUE || next_keep_pts == AV_NOPTS_VALUE) {
+            return true;
+        }
+        if (pts < next_keep_pts - frame_dur / 2) {
+            return false;
         }
-        // 写入U分量
-        for (int i = 0; i < height/2; i++) {
-            yuv_file.write(reinterpret_cast<char*>(frame->data[1] + i * frame->linesize[1]), width/2);
+        // 推进到该帧之后的下一个保留时刻（按序号计算，避免累计误差）
+        while (next_keep_pts <= pts + frame_dur / 2) {
+            keep_index++;
+            next_keep_pts = start_pts + av_rescale_q(keep_index, av_inv_q(target_fps), time_base);
         }
-        // 写入V分量
-        for (int i = 0; i < height/2; i++) {
-            yuv_file.write(reinterpret_cast<char*>(frame->data[2] + i * frame->linesize[2]), width/2);
+        return true;
+    }
+};
+
+namespace {
+
+// 解码帧的输出端：裁剪、导出YUV（可选）、推入环形缓冲区或广播环（非线程安全，由调用者保证串行）
+class DecodedFrameSink {
+public:
+    explicit DecodedFrameSink(const VideoDecodeOptions& opts) : opts(opts) {
+#if ENABLE_YUV_OUTPUT
+        if (!yuv_writer.open(YUV_OUTPUT_Y4M ? "output.y4m" : "output.yuv", YUV_OUTPUT_Y4M, opts.frame_rate)) {
+            std::cerr << "[Warning] YUV文件输出功能初始化失败，但继续解码流程\n";
+        }
+#endif
+    }
+
+    // 输出一帧，之后frame被unref
+    void push(AVFrame* frame) {
+        frame_count++;  // 👈 计数递增
+        if (opts.latency) {
+            opts.latency->on_decoded(frame);
+        }
+
+        if (!opts.crop.empty() && apply_crop(frame, opts.crop) < 0 && !crop_warned) {
+            std::cerr << "[VideoDecoder Warn] 裁剪区域超出帧尺寸，按原尺寸输出\n";
+            crop_warned = true;
         }
 
-        frame_count++;
-        // YUV 写入日志：每10帧输出一次（原逻辑已符合，保留）
+        // 🔁 高频日志：每10帧才输出
         if (frame_count % 10 == 0) {
-            std::cout << "[YUV] 已写入 " << frame_count << " 帧到YUV文件\n";
+            std::cout << "[Video] 解码YUV帧: pts=" << frame->pts
+                      << " width=" << frame->width
+                      << " height=" << frame->height
+                      << " → 推入环形缓冲区\n";
         }
+
+#if ENABLE_YUV_OUTPUT
+        yuv_writer.write_frame(frame);  // 只增加引用计数，写盘在独立线程
+#endif
+
+        if (opts.out_broadcast) {
+            opts.out_broadcast->push(frame);
+        } else if (opts.overload.policy == OverloadPolicy::DropOldest) {
+            bool dropped = false;
+            g_video_frame_ringbuf.push_drop_oldest(frame, &dropped);
+            if (dropped) {
+                on_overload_drop("丢弃缓冲区中最旧的帧");
+            }
+        } else if (opts.overload.policy == OverloadPolicy::DropNonRef && frame->pict_type == AV_PICTURE_TYPE_B) {
+            if (!g_video_frame_ringbuf.try_push(frame)) {
+                on_overload_drop("丢弃非参考帧输出");
+            }
+        } else {
+            g_video_frame_ringbuf.push(frame);
+        }
+        av_frame_unref(frame);
     }
 
-    void close() {
-        if (yuv_file.is_open()) {
-            yuv_file.close();
-            // 【结束信息】保留
-            std::cout << "[Info] YUV文件已关闭，共写入 " << frame_count << " 帧\n";
+    // 结束信号
+    void finish() {
+        if (opts.out_broadcast) {
+            opts.out_broadcast->flush();
+        } else {
+            g_video_frame_ringbuf.flush();
         }
     }
 
-    ~YUVFileWriter() {
-        close();
+    int frame_count = 0;
+    int64_t overload_dropped = 0;  // 过载策略在输出端丢弃的帧数
+
+private:
+    // 过载丢帧计数；日志按2的幂次限频
+    void on_overload_drop(const char* what) {
+        overload_dropped++;
+        if ((overload_dropped & (overload_dropped - 1)) == 0) {
+            std::cerr << "[VideoDecoder Warn] 下游过载，" << what << "（累计 " << overload_dropped << " 帧）\n";
+        }
     }
-};
+
+    const VideoDecodeOptions& opts;
+    bool crop_warned = false;
+#if ENABLE_YUV_OUTPUT
+    RawFrameWriter yuv_writer;
 #endif
+};
 
-void video_decode_thread(AVCodecParameters* codec_par) {
-    // 【启动信息】保留
-    std::cout << "start videoDecode!\n";
+// 过载策略的输入端：按环形缓冲区和Packet队列的积压决定Packet是否送解码器
+class OverloadGuard {
+public:
+    explicit OverloadGuard(const OverloadOptions& opts) : opts(opts) {}
 
-#if ENABLE_YUV_OUTPUT
-    YUVFileWriter yuv_writer;
-    if (!yuv_writer.open("output.yuv")) {
-        std::cerr << "[Warning] YUV文件输出功能初始化失败，但继续解码流程\n";
+    // 返回false表示该Packet因过载不送入解码器（在抽帧器之后调用）。DropNonRef过载时只对这一个Packet
+    // 调高skip_frame，送入解码器后须调用restore_skip恢复为调高之前的级别（可能是抽帧器设置的AVDISCARD_NONREF）
+    bool on_packet(AVCodecContext* codec_ctx, const AVPacket& pkt) {
+        if (opts.policy == OverloadPolicy::DropNonRef) {
+            bool over = overloaded();
+            if (over != active) {
+                active = over;
+                std::cerr << "[VideoDecoder Warn] " << (over ? "下游过载，开始跳过非参考帧" : "过载解除，恢复解码全部帧")
+                          << "（Packet积压 " << g_video_pkt_queue.size() << "）\n";
+            }
+            if (over) {
+                if (pkt.flags & AV_PKT_FLAG_DISPOSABLE) {
+                    skipped_pkts++;
+                    return false;
+                }
+                if (codec_ctx->skip_frame < AVDISCARD_NONREF) {
+                    saved_skip = codec_ctx->skip_frame;
+                    codec_ctx->skip_frame = AVDISCARD_NONREF;
+                    raised_skip = true;
+                }
+            }
+        } else if (opts.policy == OverloadPolicy::SkipToKeyframe) {
+            if (pkt.flags & AV_PKT_FLAG_KEY) {
+                if (active) {
+                    std::cerr << "[VideoDecoder Warn] 在关键帧 pts=" << pkt.pts << " 恢复解码（本次跳过 "
+                              << skipped_pkts - skip_start << " 个Packet）\n";
+                }
+                active = false;
+            } else if (!active && overloaded()) {
+                active = true;
+                skip_events++;
+                skip_start = skipped_pkts;
+                std::cerr << "[VideoDecoder Warn] 下游过载（Packet积压 " << g_video_pkt_queue.size()
+                          << "），丢弃到下一个关键帧\n";
+            }
+            if (active) {
+                skipped_pkts++;
+                return false;
+            }
+        }
+        return true;
     }
-#endif
 
-    const AVCodec* codec = avcodec_find_decoder(codec_par->codec_id);
-    if (!codec) {
-        std::cerr << "[Error] 找不到视频解码器\n";
-        return;
+    // 恢复on_packet调高之前的skip_frame
+    void restore_skip(AVCodecContext* codec_ctx) {
+        if (raised_skip) {
+            codec_ctx->skip_frame = saved_skip;
+            raised_skip = false;
+        }
+    }
+
+    int64_t skipped_pkts = 0;   // 因过载未解码的Packet数
+    int64_t skip_events = 0;    // SkipToKeyframe跳过的次数
+
+private:
+    bool overloaded() const {
+        return g_video_frame_ringbuf.size() >= g_video_frame_ringbuf.get_capacity() ||
+               g_video_pkt_queue.size() > opts.max_pending_packets;
     }
 
+    OverloadOptions opts;
+    bool active = false;        // DropNonRef：正在跳过非参考帧；SkipToKeyframe：正在丢到关键帧
+    bool raised_skip = false;   // 当前Packet的skip_frame是本类调高的
+    AVDiscard saved_skip = AVDISCARD_DEFAULT;  // 调高之前生效的级别
+    int64_t skip_start = 0;
+};
+
+// 按流参数创建并打开一个解码器上下文（pool非空时从帧缓冲池分配帧），失败返回nullptr。
+// low_delay时只用按片多线程（帧级多线程每个线程多延迟一帧）并打开AV_CODEC_FLAG_LOW_DELAY
+AVCodecContext* open_video_decoder(const AVCodec* codec, const AVCodecParameters* codec_par, FramePool* pool,
+                                   int thread_count, bool low_delay = false) {
     AVCodecContext* codec_ctx = avcodec_alloc_context3(codec);
     if (!codec_ctx) {
         std::cerr << "[Error] 分配视频解码器上下文失败\n";
-        return;
+        return nullptr;
     }
     if (avcodec_parameters_to_context(codec_ctx, codec_par) < 0) {
         std::cerr << "[Error] 复制视频流参数失败\n";
         avcodec_free_context(&codec_ctx);
-        return;
+        return nullptr;
+    }
+    if (thread_count > 0) {
+        codec_ctx->thread_count = thread_count;
+    }
+    if (low_delay) {
+        codec_ctx->flags |= AV_CODEC_FLAG_LOW_DELAY;
+        codec_ctx->thread_type = FF_THREAD_SLICE;
+    }
+    if (pool) {
+        pool->attach(codec_ctx);
     }
-
     if (avcodec_open2(codec_ctx, codec, nullptr) < 0) {
         std::cerr << "[Error] 打开视频解码器失败\n";
         avcodec_free_context(&codec_ctx);
-        return;
+        return nullptr;
     }
+    return codec_ctx;
+}
 
-    AVPacket pkt;
+// ============ 帧内编码流并行解码 ============
+
+// 一个待解码Packet及其序号（pkt为nullptr表示结束）
+struct IntraTask {
+    int64_t seq = 0;
+    AVPacket* pkt = nullptr;
+};
+
+// 每个解码线程的有界输入队列
+class IntraTaskQueue {
+public:
+    void push(IntraTask task) {
+        std::unique_lock<std::mutex> lock(mtx);
+        not_full.wait(lock, [&]() { return tasks.size() < kCapacity; });
+        tasks.push_back(task);
+        not_empty.notify_one();
+    }
+
+    IntraTask pop() {
+        std::unique_lock<std::mutex> lock(mtx);
+        not_empty.wait(lock, [&]() { return !tasks.empty(); });
+        IntraTask task = tasks.front();
+        tasks.pop_front();
+        not_full.notify_one();
+        return task;
+    }
+
+private:
+    static constexpr size_t kCapacity = 2;
+    std::mutex mtx;
+    std::condition_variable not_full, not_empty;
+    std::deque<IntraTask> tasks;
+};
+
+// 解码结果按Packet序号重排：序号连续的帧立即交给sink，其余暂存
+class IntraReorder {
+public:
+    explicit IntraReorder(DecodedFrameSink* sink) : sink(sink) {}
+
+    ~IntraReorder() {
+        for (auto& entry : pending) {
+            av_frame_free(&entry.second);
+        }
+    }
+
+    // frame为nullptr表示该Packet没有解出帧（仍需占位，后续序号才能继续输出）
+    void complete(int64_t seq, AVFrame* frame) {
+        std::lock_guard<std::mutex> lock(mtx);
+        pending[seq] = frame;
+        max_waiting = std::max(max_waiting, static_cast<int>(pending.size()) - 1);
+        for (auto it = pending.find(next_seq); it != pending.end(); it = pending.find(next_seq)) {
+            if (it->second) {
+                sink->push(it->second);
+                av_frame_free(&it->second);
+            }
+            pending.erase(it);
+            next_seq++;
+        }
+    }
+
+    int max_reorder_wait() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return max_waiting;
+    }
+
+private:
+    DecodedFrameSink* sink;
+    std::mutex mtx;
+    std::map<int64_t, AVFrame*> pending;
+    int64_t next_seq = 0;
+    int max_waiting = 0;
+};
+
+// 解码线程：独立的解码器上下文，每个Packet独立解出一帧
+void intra_decode_worker(int id, const AVCodec* codec, const AVCodecParameters* codec_par, FramePool* pool,
+                         IntraTaskQueue* queue, IntraReorder* reorder) {
+    // 单线程解码：并行度来自多个上下文；低延迟保证送入一个Packet立即取到对应的帧
+    AVCodecContext* codec_ctx = open_video_decoder(codec, codec_par, pool, 1, /*low_delay=*/true);
     AVFrame* frame = av_frame_alloc();
-    int frame_count = 0;  // 👈 新增帧计数器
+    int64_t decoded = 0;
 
+    while (true) {
+        IntraTask task = queue->pop();
+        if (!task.pkt) {
+            break;
+        }
+        AVFrame* out = nullptr;
+        if (codec_ctx && frame && avcodec_send_packet(codec_ctx, task.pkt) >= 0 &&
+            avcodec_receive_frame(codec_ctx, frame) >= 0) {
+            out = av_frame_alloc();
+            if (out) {
+                av_frame_move_ref(out, frame);
+                decoded++;
+            }
+            // 帧内编码每个Packet只有一帧，多出的（不应出现）直接丢弃
+            while (avcodec_receive_frame(codec_ctx, frame) >= 0) {
+                av_frame_unref(frame);
+            }
+        }
+        av_frame_unref(frame);
+        av_packet_free(&task.pkt);
+        reorder->complete(task.seq, out);
+    }
+
+    av_frame_free(&frame);
+    avcodec_free_context(&codec_ctx);
+    std::cout << "[VideoDecoder Info] 帧内并行解码器" << id << " 退出，解码 " << decoded << " 帧\n";
+}
+
+// 帧内编码流：Packet按序号轮流分给多个解码器上下文，结果按序号重排后输出
+void intra_parallel_decode(const AVCodec* codec, AVCodecParameters* codec_par, const VideoDecodeOptions& opts,
+                           FramePool* pool, FrameDecimator* decimator, DecodedFrameSink* sink) {
+    const int workers = opts.intra_workers;
+    IntraReorder reorder(sink);
+    std::vector<IntraTaskQueue> queues(workers);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < workers; i++) {
+        threads.emplace_back(intra_decode_worker, i, codec, codec_par, pool, &queues[i], &reorder);
+    }
+
+    AVPacket pkt;
+    int64_t seq = 0;
+    bool warned_non_key = false;
     while (g_video_pkt_queue.pop(pkt)) {
         if (!pkt.data) { // 空Packet：解码结束
-            avcodec_send_packet(codec_ctx, nullptr);
             break;
         }
-
-        if (avcodec_send_packet(codec_ctx, &pkt) < 0) {
-            std::cerr << "[Warn] 视频Packet发送失败\n";
+        if (!(pkt.flags & AV_PKT_FLAG_KEY) && !warned_non_key) {
+            std::cerr << "[VideoDecoder Warn] 帧内并行解码遇到非关键帧Packet，该流可能不是全I帧\n";
+            warned_non_key = true;
+        }
+        if (!decimator->on_intra_packet(pkt)) {
             av_packet_unref(&pkt);
             continue;
         }
+        IntraTask task;
+        task.seq = seq;
+        task.pkt = av_packet_alloc();
+        if (!task.pkt) {
+            av_packet_unref(&pkt);
+            continue;
+        }
+        av_packet_move_ref(task.pkt, &pkt);
+        queues[seq % workers].push(task);
+        seq++;
+    }
+
+    for (auto& queue : queues) {
+        queue.push(IntraTask());
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    std::cout << "[VideoDecoder Info] 帧内并行解码：" << workers << " 个解码器，" << seq
+              << " 个Packet，重排缓冲最多等待 " << reorder.max_reorder_wait() << " 帧\n";
+}
+
+} // namespace
+
+void video_decode_thread(AVCodecParameters* codec_par, VideoDecodeOptions opts) {
+    // 【启动信息】保留
+    std::cout << "start videoDecode!\n";
+
+    DecodedFrameSink sink(opts);
+
+    const AVCodec* codec = avcodec_find_decoder(codec_par->codec_id);
+    if (!codec) {
+        std::cerr << "[Error] 找不到视频解码器\n";
+        return;
+    }
+
+    FrameDecimator decimator;
+    decimator.init(opts, codec_par);
+    OverloadGuard overload(opts.overload);
+    if (opts.overload.policy != OverloadPolicy::Block && opts.out_broadcast) {
+        std::cerr << "[VideoDecoder Warn] 输出到广播环时过载策略不生效\n";
+    }
+
+#if ENABLE_FRAME_POOL
+    FramePoolOptions pool_opts;
+    pool_opts.huge_page = FRAME_POOL_HUGE_PAGE;
+    FramePool frame_pool(pool_opts);
+    FramePool* pool = &frame_pool;
+#else
+    FramePool* pool = nullptr;
+#endif
 
-        // 接收解码帧 → 推入环形缓冲区
-        while (avcodec_receive_frame(codec_ctx, frame) >= 0) {
-            frame_count++;  // 👈 计数递增
+    // 帧内编码（每个Packet独立可解）且要求多个解码器时走并行路径
+    const AVCodecDescriptor* desc = avcodec_descriptor_get(codec_par->codec_id);
+    bool intra_only = opts.assume_intra_only || (desc && (desc->props & AV_CODEC_PROP_INTRA_ONLY));
+    if (intra_only && opts.intra_workers > 1) {
+        // 【一次性信息】保留
+        std::cout << "[VideoDecoder Info] " << avcodec_get_name(codec_par->codec_id) << " 为帧内编码，使用 "
+                  << opts.intra_workers << " 个解码器并行解码\n";
+#if ENABLE_FRAME_POOL
+        frame_pool.set_prewarm_count(static_cast<int>(g_video_frame_ringbuf.get_capacity()) + 2 +
+                                     2 * opts.intra_workers);
+#endif
+        intra_parallel_decode(codec, codec_par, opts, pool, &decimator, &sink);
+    } else {
+        AVCodecContext* codec_ctx = open_video_decoder(codec, codec_par, pool, 0, opts.low_delay);
+        if (!codec_ctx) {
+            return;
+        }
+
+#if ENABLE_FRAME_POOL
+        // 稳态下同时存活的帧：环形缓冲区 + 解码线程/编码线程各持有一帧 + 帧线程
+        // （参考帧和重排延迟在首次分配时由get_buffer2按解码器状态追加）
+        frame_pool.set_prewarm_count(static_cast<int>(g_video_frame_ringbuf.get_capacity()) + 2 +
+                                     std::max(codec_ctx->thread_count, 1));
+#endif
 
-            // 🔁 高频日志：每10帧才输出
-            if (frame_count % 10 == 0) {
-                std::cout << "[Video] 解码YUV帧: pts=" << frame->pts
-                          << " width=" << frame->width
-                          << " height=" << frame->height
-                          << " → 推入环形缓冲区\n";
+        AVPacket pkt;
+        AVFrame* frame = av_frame_alloc();
+
+        while (g_video_pkt_queue.pop(pkt)) {
+            if (!pkt.data) { // 空Packet：解码结束
+                avcodec_send_packet(codec_ctx, nullptr);
+                break;
             }
 
-#if ENABLE_YUV_OUTPUT
-            if (frame->format == AV_PIX_FMT_YUV420P) {
-                yuv_writer.write_frame(frame);  // 内部已有 10 帧节流
-            } else {
-                // 非YUV420P提示：也应节流（避免刷屏）
-                if (frame_count % 10 == 0) {
-                    std::cout << "[Info] 非YUV420P格式(" << frame->format
-                              << ")，跳过YUV文件写入\n";
-                }
+            if (!decimator.on_packet(codec_ctx, pkt) || !overload.on_packet(codec_ctx, pkt)) {
+                av_packet_unref(&pkt);
+                continue;
             }
-#endif
 
-            g_video_frame_ringbuf.push(frame);
-            av_frame_unref(frame);
+            int send_ret = avcodec_send_packet(codec_ctx, &pkt);
+            overload.restore_skip(codec_ctx);
+            if (send_ret < 0) {
+                std::cerr << "[Warn] 视频Packet发送失败\n";
+                av_packet_unref(&pkt);
+                continue;
+            }
+
+            // 接收解码帧 → 推入环形缓冲区
+            while (avcodec_receive_frame(codec_ctx, frame) >= 0) {
+                if (!decimator.on_frame(frame)) {
+                    av_frame_unref(frame);
+                    continue;
+                }
+                sink.push(frame);
+            }
+            av_packet_unref(&pkt);
         }
-        av_packet_unref(&pkt);
+
+        av_frame_free(&frame);
+        avcodec_free_context(&codec_ctx);
     }
 
     // 结束信号
-    g_video_frame_ringbuf.flush();
-    av_frame_free(&frame);
-    avcodec_free_context(&codec_ctx);
+    sink.finish();
 
     // 【可选：补充总结信息】
-    std::cout << "[VideoDecoder Info] 视频解码线程退出，共处理 " << frame_count << " 帧\n";
-}
\ No newline at end of file
+    std::cout << "[VideoDecoder Info] 视频解码线程退出，共处理 " << sink.frame_count << " 帧\n";
+    if (decimator.is_enabled()) {
+        std::cout << "[VideoDecoder Info] 抽帧统计：跳过Packet " << decimator.dropped_pkts
+                  << " 个，丢弃解码帧 " << decimator.dropped_frames << " 帧\n";
+    }
+    if (opts.overload.policy != OverloadPolicy::Block) {
+        std::cout << "[VideoDecoder Info] 过载统计：未解码Packet " << overload.skipped_pkts << " 个（跳到关键帧 "
+                  << overload.skip_events << " 次），输出端丢弃 " << sink.overload_dropped << " 帧\n";
+        g_job_stats.add_count("decode.overload_skipped_pkts", overload.skipped_pkts);
+        g_job_stats.add_count("decode.overload_dropped_frames", sink.overload_dropped);
+    }
+}
@@ -2,107 +2,124 @@
 // Created by Jianing on 2025/12/22.
 //
 #include "videoencoder.h"
+#include "pixfmt_convert.h"
+#include "job_stats.h"
+#include <cstring>
 #include <iostream>
 extern "C" {
 #include <libavformat/avformat.h>
 #include <libavcodec/avcodec.h>
 #include <libavutil/avutil.h>
 #include <libavutil/imgutils.h>
+#include <libavutil/pixdesc.h>
 #include <libavutil/error.h>
 }
 
-void video_encode_thread(AVCodecParameters* src_codec_par, AVRational output_time_base) {
+namespace {
+
+// 编码pts：给定源时间基时把源时间戳换算到编码时间基（从0开始、严格递增），
+// 丢帧后保留帧之间的间隔随之变大，输出即为VFR；否则按帧序号
+class PtsMapper {
+public:
+    PtsMapper(AVRational src_tb, AVRational enc_tb) : src_tb(src_tb), enc_tb(enc_tb) {}
+
+    int64_t map(const AVFrame* frame, int64_t frame_index) {
+        int64_t ts = frame->pts != AV_NOPTS_VALUE ? frame->pts : frame->best_effort_timestamp;
+        int64_t pts = frame_index;
+        if (src_tb.num > 0 && src_tb.den > 0 && ts != AV_NOPTS_VALUE) {
+            if (first_ts == AV_NOPTS_VALUE) {
+                first_ts = ts;
+            }
+            pts = av_rescale_q(ts - first_ts, src_tb, enc_tb);
+        } else if (first_ts != AV_NOPTS_VALUE) {
+            pts = last_pts + 1;  // 源时间戳中途缺失：紧接上一帧
+        }
+        // 编码器要求严格递增（源时间戳回退或换算后重合时顺延）
+        if (last_pts != AV_NOPTS_VALUE && pts <= last_pts) {
+            pts = last_pts + 1;
+        }
+        last_pts = pts;
+        return pts;
+    }
+
+private:
+    AVRational src_tb, enc_tb;
+    int64_t first_ts = AV_NOPTS_VALUE;
+    int64_t last_pts = AV_NOPTS_VALUE;
+};
+
+} // namespace
+
+void video_encode_thread(AVCodecParameters* src_codec_par, AVRational output_time_base,
+                         VideoEncodeOptions opts) {
     if (!src_codec_par) {
         std::cerr << "[VideoEncoder Error] 输入编码器参数为空指针！\n";
         return;
     }
 
-    const AVCodec* encoder = avcodec_find_encoder(AV_CODEC_ID_MPEG4);
-    if (!encoder) {
-        std::cerr << "[VideoEncoder Error] 找不到MPEG4编码器\n";
-        return;
+    // 场景切换检测开启时由检测器强制关键帧，编码器自身的GOP只作为上限
+    EncoderProfile profile = opts.profile;
+    if (profile.color_range == AVCOL_RANGE_UNSPECIFIED) {
+        profile.color_range = yuv420p_color_range(static_cast<AVPixelFormat>(src_codec_par->format),
+                                                  src_codec_par->color_range);
     }
-
-    AVCodecContext* enc_ctx = avcodec_alloc_context3(encoder);
-    if (!enc_ctx) {
-        std::cerr << "[VideoEncoder Error] 分配视频编码器上下文失败\n";
-        return;
+    if (opts.scene_cut.enabled) {
+        profile.gop_size = opts.scene_cut.max_gop;
     }
-
-    // 设置编码参数
-    enc_ctx->codec_id = AV_CODEC_ID_MPEG4;
-    enc_ctx->width = src_codec_par->width;
-    enc_ctx->height = src_codec_par->height;
-    enc_ctx->pix_fmt = AV_PIX_FMT_YUV420P;
-    enc_ctx->time_base = output_time_base;  // 设置为输出时间基1/25
-    enc_ctx->framerate = av_inv_q(output_time_base);
-    enc_ctx->bit_rate = 1000000;
-    enc_ctx->gop_size = 10;
-    enc_ctx->max_b_frames = 0;
-
-    // 对于MPEG4，设置正确的codec_tag（mp4v）
-    // 0x7634706d = 'mp4v' 的小端表示
-    enc_ctx->codec_tag = 0x7634706d;
-
-    int ret = avcodec_open2(enc_ctx, encoder, nullptr);
-    if (ret < 0) {
-        char err_buf[1024];
-        av_strerror(ret, err_buf, sizeof(err_buf));
-        std::cerr << "[VideoEncoder Error] 打开MPEG4编码器失败：" << err_buf << "\n";
-        avcodec_free_context(&enc_ctx);
+    // 实时模式换档时重开编码器，有B帧时前后两个编码器的dts会交叠，这里一律不用B帧
+    std::vector<EncoderProfile> effort_levels{profile};
+    if (opts.realtime.enabled) {
+        if (profile.max_b_frames > 0) {
+            std::cerr << "[VideoEncoder Warn] 实时模式不使用B帧，配置 " << profile.name << " 的 "
+                      << profile.max_b_frames << " 个B帧已关闭\n";
+            profile.max_b_frames = 0;
+        }
+        effort_levels = make_effort_levels(profile);
+        if (effort_levels.size() < 2) {
+            std::cerr << "[VideoEncoder Warn] 编码器 " << profile.codec << " 没有可切换的编码档位，实时模式只记录落后\n";
+        }
+    }
+    AVCodecContext* enc_ctx = open_video_encoder(profile, src_codec_par->width, src_codec_par->height,
+                                                 output_time_base);
+    if (!enc_ctx) {
         return;
     }
 
     // 【一次性信息】保留输出
-    std::cout << "[VideoEncoder Info] MPEG4编码器打开成功（分辨率："
-              << enc_ctx->width << "x" << enc_ctx->height
+    std::cout << "[VideoEncoder Info] " << enc_ctx->codec->name << "编码器打开成功（配置 " << profile.name
+              << "，分辨率：" << enc_ctx->width << "x" << enc_ctx->height
               << ", codec_tag=0x" << std::hex << enc_ctx->codec_tag << std::dec
-              << "）\n";
+              << ", B帧 " << enc_ctx->max_b_frames << "）\n";
 
     AVFrame* local_frame = av_frame_alloc();
+    AVFrame* conv_frame = av_frame_alloc();  // 源格式不是YUV420P时的转换结果
     AVPacket* pkt = av_packet_alloc();
-    if (!local_frame || !pkt) {
+    if (!local_frame || !conv_frame || !pkt) {
         std::cerr << "[VideoEncoder Error] 分配Frame/Packet失败\n";
         avcodec_free_context(&enc_ctx);
         if (local_frame) av_frame_free(&local_frame);
+        if (conv_frame) av_frame_free(&conv_frame);
         if (pkt) av_packet_free(&pkt);
         return;
     }
+    FramePool conv_pool;
+    bool conv_logged = false;
+    int ret = 0;
+    SceneCutDetector scene_detector(opts.scene_cut);
+    QualityMeter quality_meter(opts.quality);
+    DuplicateFrameFilter dedup(opts.dedup);
+    PtsMapper pts_mapper(opts.src_time_base, enc_ctx->time_base);
+    if (opts.quality.enabled) {
+        quality_meter.open(enc_ctx);  // 失败时只是不评估，编码照常
+    }
 
     int frame_count = 0;
+    EffortController effort(opts.realtime, static_cast<int>(effort_levels.size()));
+    int effort_level = 0;
+    int gop_frames = 0;
 
-    while (true) {
-        // 从环形缓冲区获取一帧数据
-        bool success = g_video_frame_ringbuf.pop(local_frame);
-        if (!success) {
-            // 【退出信息】保留输出
-            std::cout << "[VideoEncoder Info] 环形缓冲区已空，停止接收帧\n";
-            break;
-        }
-
-        frame_count++;
-
-        // 检查帧的有效性
-        if (!local_frame->data[0]) {
-            std::cerr << "[VideoEncoder Warn] 无效视频Frame（第" << frame_count << "帧），跳过\n";
-            av_frame_unref(local_frame);
-            continue;
-        }
-
-        // 设置时间戳 - 使用简单的递增方式
-        local_frame->pts = frame_count - 1;
-
-        // 发送frame到编码器
-        ret = avcodec_send_frame(enc_ctx, local_frame);
-        if (ret < 0) {
-            char err_buf[1024];
-            av_strerror(ret, err_buf, sizeof(err_buf));
-            std::cerr << "[VideoEncoder Warn] 第" << frame_count << "帧编码发送失败：" << err_buf << "\n";
-            av_frame_unref(local_frame);
-            continue;
-        }
-
-        // 接收编码后的packet
+    // 取出编码器当前可输出的全部packet推入输出队列
+    auto drain_packets = [&]() {
         while (true) {
             ret = avcodec_receive_packet(enc_ctx, pkt);
             if (ret == AVERROR(EAGAIN)) {
@@ -116,8 +133,18 @@ void video_encode_thread(AVCodecParameters* src_codec_par, AVRational output_tim
                 break;
             }
 
-            // 设置流索引和时间戳
+            // 时间戳转换前送去重建（与源帧同为编码器时间基）
+            quality_meter.on_packet(pkt);
+            if (opts.latency) {
+                opts.latency->on_encoded(pkt->pts);
+            }
+
+            // 设置流索引和时间戳：pts为源帧的pts，dts由编码器按编码顺序给出（有B帧时开头为负），
+            // 两者一起换算，复用线程再换算到流时间基
             pkt->stream_index = 0;
+            if (pkt->duration <= 0) {
+                pkt->duration = av_rescale_q(1, av_inv_q(enc_ctx->framerate), enc_ctx->time_base);
+            }
             av_packet_rescale_ts(pkt, enc_ctx->time_base, output_time_base);
 
             // 关键帧提示：每10帧才输出
@@ -127,18 +154,147 @@ void video_encode_thread(AVCodecParameters* src_codec_par, AVRational output_tim
 
             // 主编码日志：每10帧才输出
             if (frame_count % 10 == 0) {
-                std::cout << "[VideoEncoder Info] 编码MPEG4 Packet: pts=" << pkt->pts
+                std::cout << "[VideoEncoder Info] 编码视频Packet: pts=" << pkt->pts << " dts=" << pkt->dts
                           << " size=" << pkt->size << "（第" << frame_count << "帧）\n";
             }
 
             // 推送到队列（始终执行）
-            g_en_video_pkt_queue.push(*pkt);
+            opts.out_queue->push(*pkt);
             av_packet_unref(pkt);
         }
+    };
+
+    // 实时模式换档：先打开新档位的编码器（失败则保持原档位），再刷出旧编码器的剩余packet，
+    // 新编码器从关键帧开始，时间基和pts序列不变
+    auto switch_effort = [&](int level) {
+        const EncoderProfile& next = effort_levels[level];
+        AVCodecContext* next_ctx = open_video_encoder(next, enc_ctx->width, enc_ctx->height, output_time_base);
+        if (!next_ctx) {
+            std::cerr << "[VideoEncoder Warn] 档位 " << level << " 的编码器打开失败，保持档位 " << effort_level << "\n";
+            return;
+        }
+        // 复用参数按第0档导出，码流头（extradata）变了的档位不能中途切换
+        if (next_ctx->extradata_size != enc_ctx->extradata_size ||
+            (enc_ctx->extradata_size > 0 &&
+             memcmp(next_ctx->extradata, enc_ctx->extradata, enc_ctx->extradata_size) != 0)) {
+            std::cerr << "[VideoEncoder Warn] 档位 " << level << "（" << next.name << "）的码流头与当前编码器不同，"
+                      << "不能切换，保持档位 " << effort_level << "\n";
+            avcodec_free_context(&next_ctx);
+            return;
+        }
+        avcodec_send_frame(enc_ctx, nullptr);
+        drain_packets();
+        avcodec_free_context(&enc_ctx);
+        enc_ctx = next_ctx;
+        effort_level = level;
+        std::cout << "[VideoEncoder Info] 实时模式切换到档位 " << level << "（" << next.name << "，选项 "
+                  << (next.options.empty() ? "无" : next.options) << "，线程 " << enc_ctx->thread_count << "）\n";
+    };
+
+    while (true) {
+        // 从环形缓冲区获取一帧数据
+        bool success = opts.in_ringbuf->pop(local_frame);
+        if (!success) {
+            // 【退出信息】保留输出
+            std::cout << "[VideoEncoder Info] 环形缓冲区已空，停止接收帧\n";
+            break;
+        }
+
+        frame_count++;
+
+        // 检查帧的有效性
+        if (!local_frame->data[0]) {
+            std::cerr << "[VideoEncoder Warn] 无效视频Frame（第" << frame_count << "帧），跳过\n";
+            av_frame_unref(local_frame);
+            continue;
+        }
+
+        // 解码器输出NV12/YUVJ420P/YUV422P/YUYV422等格式时先转成编码器的YUV420P
+        AVFrame* send_frame = local_frame;
+        AVPixelFormat src_fmt = static_cast<AVPixelFormat>(local_frame->format);
+        if (src_fmt != enc_ctx->pix_fmt && can_convert_to_yuv420p(src_fmt)) {
+            ret = convert_to_yuv420p(local_frame, conv_frame, &conv_pool);
+            if (ret < 0) {
+                std::cerr << "[VideoEncoder Warn] 第" << frame_count << "帧像素格式转换失败，跳过\n";
+                av_frame_unref(local_frame);
+                continue;
+            }
+            if (!conv_logged) {
+                // 【一次性信息】保留
+                std::cout << "[VideoEncoder Info] 输入像素格式 " << av_get_pix_fmt_name(src_fmt)
+                          << "，转换为 yuv420p 后编码\n";
+                conv_logged = true;
+            }
+            send_frame = conv_frame;
+        }
+
+        // 与上一保留帧相同（或差异在阈值内）的帧不送编码器
+        if (opts.dedup.enabled && dedup.is_duplicate(send_frame)) {
+            av_frame_unref(conv_frame);
+            av_frame_unref(local_frame);
+            continue;
+        }
+
+        // 设置时间戳：给定源时间基时按源时间戳，否则按帧序号递增
+        send_frame->pts = pts_mapper.map(send_frame, frame_count - 1);
+        if (opts.latency) {
+            opts.latency->on_encode(local_frame, send_frame->pts);  // 时间戳在解码输出帧的opaque_ref上
+        }
+
+        // 场景切换处强制I帧；其余帧清掉解码器带来的帧类型，由编码器自行决定
+        if (opts.scene_cut.enabled) {
+            send_frame->pict_type = scene_detector.next_keyframe(send_frame) ? AV_PICTURE_TYPE_I
+                                                                              : AV_PICTURE_TYPE_NONE;
+        }
 
+        // 实时模式：GOP边界（场景切换强制的I帧，否则按gop_size计数）决定下一段的档位，
+        // 再按该帧源时间和输入缓冲区占用统计落后情况
+        if (opts.realtime.enabled) {
+            bool gop_start = opts.scene_cut.enabled ? send_frame->pict_type == AV_PICTURE_TYPE_I
+                                                    : gop_frames >= profile.gop_size;
+            if (gop_start) {
+                gop_frames = 0;
+                int level = effort.on_gop_boundary();
+                if (level != effort_level) {
+                    switch_effort(level);
+                }
+            }
+            effort.on_frame(send_frame->pts * av_q2d(enc_ctx->time_base), opts.in_ringbuf->size(),
+                            opts.in_ringbuf->get_capacity());
+            gop_frames++;
+        }
+
+        quality_meter.add_source(send_frame);
+
+        // 发送frame到编码器
+        ret = avcodec_send_frame(enc_ctx, send_frame);
+        av_frame_unref(conv_frame);
+        if (ret < 0) {
+            char err_buf[1024];
+            av_strerror(ret, err_buf, sizeof(err_buf));
+            std::cerr << "[VideoEncoder Warn] 第" << frame_count << "帧编码发送失败：" << err_buf << "\n";
+            av_frame_unref(local_frame);
+            continue;
+        }
+
+        drain_packets();
         av_frame_unref(local_frame);
     }
 
+    // 最后一段重复帧整体被丢弃时补编最后一帧，否则输出会比源短这一段
+    if (AVFrame* tail = dedup.take_tail()) {
+        tail->pts = pts_mapper.map(tail, frame_count - 1);
+        tail->pict_type = AV_PICTURE_TYPE_NONE;
+        quality_meter.add_source(tail);
+        if (opts.latency) {
+            opts.latency->on_excluded();  // 补编的末帧早已采集，延迟没有意义
+        }
+        if (avcodec_send_frame(enc_ctx, tail) >= 0) {
+            drain_packets();
+        }
+        av_frame_free(&tail);
+    }
+
     // 刷新编码器（一次性信息，保留）
     std::cout << "[VideoEncoder Info] 开始刷新编码器剩余数据（共处理" << frame_count << "帧）\n";
     ret = avcodec_send_frame(enc_ctx, nullptr);
@@ -148,31 +304,35 @@ void video_encode_thread(AVCodecParameters* src_codec_par, AVRational output_tim
         std::cerr << "[VideoEncoder Warn] 刷新编码器失败：" << err_buf << "\n";
     }
 
-    while (true) {
-        ret = avcodec_receive_packet(enc_ctx, pkt);
-        if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
-            break;
-        } else if (ret < 0) {
-            char err_buf[1024];
-            av_strerror(ret, err_buf, sizeof(err_buf));
-            std::cerr << "[VideoEncoder Warn] 刷新时接收编码包失败：" << err_buf << "\n";
-            break;
-        }
-
-        av_packet_rescale_ts(pkt, enc_ctx->time_base, output_time_base);
-        pkt->stream_index = 0;
-        g_en_video_pkt_queue.push(*pkt);
-        av_packet_unref(pkt);
-    }
+    // 有B帧时最后几帧在这里输出
+    drain_packets();
+    quality_meter.finish();
 
     // 标记队列结束
-    g_en_video_pkt_queue.mark_done();
+    opts.out_queue->mark_done();
 
     // 释放资源
     av_frame_free(&local_frame);
+    av_frame_free(&conv_frame);
     av_packet_free(&pkt);
     avcodec_free_context(&enc_ctx);
 
     // 【退出总结】保留输出
     std::cout << "[VideoEncoder Info] 视频编码线程退出，共处理" << frame_count << "帧\n";
+    if (opts.scene_cut.enabled) {
+        std::cout << "[VideoEncoder Info] 场景切换关键帧 " << scene_detector.scene_cuts()
+                  << " 个，按最长GOP(" << opts.scene_cut.max_gop << ")插入 " << scene_detector.gop_keyframes()
+                  << " 个\n";
+        g_job_stats.add_count("encode.scene_cuts", scene_detector.scene_cuts());
+        g_job_stats.add_count("encode.gop_keyframes", scene_detector.gop_keyframes());
+    }
+    if (opts.dedup.enabled) {
+        std::cout << "[VideoEncoder Info] 丢弃重复帧 " << dedup.dropped() << " 帧\n";
+        g_job_stats.add_count("encode.dup_dropped", dedup.dropped());
+    }
+    if (opts.realtime.enabled) {
+        std::cout << "[VideoEncoder Info] 实时模式：最大落后 " << effort.max_lateness() << "s，切换档位 "
+                  << effort.changes() << " 次，结束时档位 " << effort_level << "\n";
+        g_job_stats.add_count("encode.effort_changes", effort.changes());
+    }
 }
\ No newline at end of file
@@ -0,0 +1,65 @@
+//
+// Created by Jianing on 2026/01/10.
+//
+#include "y4m.h"
+#include <cstring>
+
+namespace {
+
+struct Y4MFormat {
+    AVPixelFormat pix_fmt;
+    const char* tag;
+};
+
+// 与FFmpeg yuv4mpegenc的映射保持一致（420按JPEG色度位置写出）
+const Y4MFormat kY4MFormats[] = {
+        {AV_PIX_FMT_YUV420P,     "420jpeg"},
+        {AV_PIX_FMT_YUVJ420P,    "420jpeg"},
+        {AV_PIX_FMT_YUV411P,     "411"},
+        {AV_PIX_FMT_YUV422P,     "422"},
+        {AV_PIX_FMT_YUVJ422P,    "422"},
+        {AV_PIX_FMT_YUV444P,     "444"},
+        {AV_PIX_FMT_YUVJ444P,    "444"},
+        {AV_PIX_FMT_YUVA444P,    "444alpha"},
+        {AV_PIX_FMT_GRAY8,       "mono"},
+        {AV_PIX_FMT_GRAY16LE,    "mono16"},
+        {AV_PIX_FMT_YUV420P9LE,  "420p9"},
+        {AV_PIX_FMT_YUV422P9LE,  "422p9"},
+        {AV_PIX_FMT_YUV444P9LE,  "444p9"},
+        {AV_PIX_FMT_YUV420P10LE, "420p10"},
+        {AV_PIX_FMT_YUV422P10LE, "422p10"},
+        {AV_PIX_FMT_YUV444P10LE, "444p10"},
+        {AV_PIX_FMT_YUV420P12LE, "420p12"},
+        {AV_PIX_FMT_YUV422P12LE, "422p12"},
+        {AV_PIX_FMT_YUV444P12LE, "444p12"},
+        {AV_PIX_FMT_YUV420P14LE, "420p14"},
+        {AV_PIX_FMT_YUV422P14LE, "422p14"},
+        {AV_PIX_FMT_YUV444P14LE, "444p14"},
+        {AV_PIX_FMT_YUV420P16LE, "420p16"},
+        {AV_PIX_FMT_YUV422P16LE, "422p16"},
+        {AV_PIX_FMT_YUV444P16LE, "444p16"},
+};
+
+} // namespace
+
+const char* y4m_chroma_tag(AVPixelFormat pix_fmt) {
+    for (const auto& fmt : kY4MFormats) {
+        if (fmt.pix_fmt == pix_fmt) {
+            return fmt.tag;
+        }
+    }
+    return nullptr;
+}
+
+AVPixelFormat y4m_pix_fmt_from_tag(const char* tag) {
+    if (!tag || !strcmp(tag, "420") || !strcmp(tag, "420paldv") || !strcmp(tag, "420mpeg2")) {
+        return AV_PIX_FMT_YUV420P;
+    }
+    for (const auto& fmt : kY4MFormats) {
+        // 420jpeg/422/444对应多个格式时取表中第一个（非J格式）
+        if (!strcmp(fmt.tag, tag)) {
+            return fmt.pix_fmt;
+        }
+    }
+    return AV_PIX_FMT_NONE;
+}